@@ -0,0 +1,424 @@
+#include <dmsc/contact_plan.hpp>
+#include <dmsc/instance.hpp>
+#include <dmsc/solver/greedy_next.hpp>
+#include <dmsc/solver/greedy_next_khop.hpp>
+#include <dmsc/visibility_index.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//===================================
+// Benchmarks of the hot paths of the library: orbit propagation, line of sight, visibility index, contact plan,
+// solvers, instance files and instance copies. Every benchmark runs on the real world instances (resources/instances)
+// and on synthetic Walker constellations of the given sizes. The results are written as JSON, so they can be compared
+// between builds:
+//
+// dmsc_bench [--output results.json] [--filter name] [--min-time sec] [--workers n] [--synthetic n1,n2,...]
+//            [--instances dir]
+//===================================
+
+#ifndef DMSC_BENCH_INSTANCES
+#define DMSC_BENCH_INSTANCES "resources/instances"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string output = "";                         // JSON file (empty: stdout)
+    std::string filter = "";                         // only benchmarks whose name contains this string
+    std::string instance_dir = DMSC_BENCH_INSTANCES; // real world instances
+    double min_time = 0.5;                           // [sec] minimal measuring time per benchmark
+    unsigned int workers = 1;                        // threads of the index and the solvers (0: all hardware threads)
+    std::vector<size_t> synthetic = {400, 1600};     // number of satellites of the synthetic constellations
+};
+
+/**
+ * @brief A constellation with ISLs and scheduled communications, shared by all benchmarks.
+ */
+struct BenchInstance {
+    std::string name;
+    dmsc::Instance raw;
+    std::shared_ptr<const dmsc::PhysicalInstance> physical;
+    std::shared_ptr<const dmsc::VisibilityIndex> visibility; // built by the first benchmark that needs it
+};
+
+struct Result {
+    std::string name;
+    std::string instance;
+    size_t satellites = 0;
+    size_t isls = 0;
+    size_t iterations = 0;
+    size_t items = 0;                                     // items per iteration (e.g. satellites)
+    double min = 0., median = 0., mean = 0.;              // [ns] per item
+    std::vector<std::pair<std::string, double>> counters; // additional values (e.g. quality of a solution)
+};
+
+volatile float sink = 0.f; // the results of the micro benchmarks are used, so they are not optimized away
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Calls f until min_time passed (at least once after a warm up call) and returns the time per item.
+ */
+Result measure(const Options& options, const std::string& name, const BenchInstance& instance, const size_t items,
+               const std::function<void()>& f) {
+    f(); // warm up (caches, lazy initialization)
+
+    std::vector<double> samples; // [ns] per iteration
+    double total = 0.;           // [sec]
+    while (samples.empty() || total < options.min_time) {
+        auto t_start = Clock::now();
+        f();
+        std::chrono::duration<double> diff = Clock::now() - t_start;
+        samples.push_back(diff.count() * 1e9);
+        total += diff.count();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    Result result;
+    result.name = name;
+    result.instance = instance.name;
+    result.satellites = instance.physical->satelliteCount();
+    result.isls = instance.physical->islCount();
+    result.iterations = samples.size();
+    result.items = std::max<size_t>(items, 1);
+    result.min = samples.front() / result.items;
+    result.median = samples[samples.size() / 2] / result.items;
+    for (double sample : samples) {
+        result.mean += sample;
+    }
+    result.mean /= samples.size() * result.items;
+    return result;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Walker delta constellation i: n/p/1 with p ~ sqrt(n) planes in a low earth orbit.
+ */
+dmsc::Instance walkerConstellation(const size_t satellite_count) {
+    size_t planes = std::max<size_t>(1, static_cast<size_t>(std::round(std::sqrt(satellite_count))));
+    size_t per_plane = (satellite_count + planes - 1) / planes;
+    float two_pi = dmsc::rad(360.f);
+
+    dmsc::Instance instance;
+    dmsc::StateVector sv;
+    sv.height_perigee = 550.f;
+    sv.inclination = dmsc::rad(53.f);
+    for (size_t i = 0; i < satellite_count; i++) {
+        size_t plane = i / per_plane;
+        size_t slot = i % per_plane;
+        sv.raan = two_pi * plane / planes;
+        sv.initial_true_anomaly = std::fmod(two_pi * (slot + static_cast<float>(plane) / planes) / per_plane, two_pi);
+        instance.satellites.push_back(sv);
+    }
+    return instance;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Connects every satellite with its ISL_NEIGHBOURS nearest satellites at t = 0 (similar to the grid of a real
+ * constellation) and adds a scheduled communication for every tenth satellite.
+ */
+BenchInstance prepareInstance(const std::string& name, dmsc::Instance raw) {
+    const size_t ISL_NEIGHBOURS = 4;
+    std::vector<glm::vec3> positions;
+    for (const dmsc::StateVector& sv : raw.satellites) {
+        positions.push_back(dmsc::Satellite(sv, raw.cm).cartesian_coordinates(0.f));
+    }
+    uint32_t n = static_cast<uint32_t>(positions.size());
+
+    std::vector<uint64_t> pairs; // (smaller index << 32) | larger index
+    std::vector<std::pair<float, uint32_t>> neighbours;
+    for (uint32_t i = 0; i < n; i++) {
+        neighbours.clear();
+        for (uint32_t j = 0; j < n; j++) {
+            if (i != j) {
+                neighbours.push_back({glm::length(positions[i] - positions[j]), j});
+            }
+        }
+        size_t count = std::min(ISL_NEIGHBOURS, neighbours.size());
+        std::partial_sort(neighbours.begin(), neighbours.begin() + count, neighbours.end());
+        for (size_t k = 0; k < count; k++) {
+            uint32_t j = neighbours[k].second;
+            pairs.push_back(static_cast<uint64_t>(std::min(i, j)) << 32 | std::max(i, j));
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    for (uint64_t pair : pairs) {
+        raw.edges.push_back(dmsc::Edge(static_cast<uint32_t>(pair >> 32), static_cast<uint32_t>(pair)));
+    }
+
+    // same communications on every run
+    std::mt19937 random(1u);
+    for (size_t i = 0; n > 1 && i < std::max<size_t>(1, n / 10); i++) {
+        uint32_t from = random() % n;
+        uint32_t to = (from + 1 + random() % (n - 1)) % n;
+        raw.edges.push_back(dmsc::Edge(from, to, dmsc::EdgeType::SCHEDULED_COMMUNICATION));
+    }
+
+    BenchInstance instance;
+    instance.name = name;
+    instance.physical = std::make_shared<const dmsc::PhysicalInstance>(raw);
+    instance.raw = std::move(raw);
+    return instance;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void runBenchmarks(const Options& options, BenchInstance& instance, std::vector<Result>& results) {
+    const dmsc::PhysicalInstance& physical = *instance.physical;
+    auto enabled = [&](const std::string& name) {
+        bool run = name.find(options.filter) != std::string::npos;
+        if (run) {
+            fprintf(stderr, "%-24s %s\n", name.c_str(), instance.name.c_str());
+        }
+        return run;
+    };
+
+    if (enabled("cartesian_coordinates")) {
+        float t = 0.f;
+        results.push_back(measure(options, "cartesian_coordinates", instance, physical.satelliteCount(), [&]() {
+            t += 7.3f;
+            glm::vec3 sum = glm::vec3(0.f);
+            for (const dmsc::Satellite& satellite : physical.getSatellites()) {
+                sum += satellite.cartesian_coordinates(t);
+            }
+            sink = sink + sum.x;
+        }));
+    }
+
+    if (enabled("is_blocked")) {
+        float t = 0.f;
+        results.push_back(measure(options, "is_blocked", instance, physical.islCount(), [&]() {
+            t += 7.3f;
+            int blocked = 0;
+            for (const dmsc::InterSatelliteLink& isl : physical.getISLs()) {
+                blocked += isl.isBlocked(t);
+            }
+            sink = sink + blocked;
+        }));
+    }
+
+    // replaces Solver::createCache - all solvers below share the same index
+    auto visibility = [&]() {
+        if (instance.visibility == nullptr) {
+            instance.visibility = std::make_shared<const dmsc::VisibilityIndex>(physical, options.workers);
+        }
+        return instance.visibility;
+    };
+    if (enabled("visibility_index")) {
+        results.push_back(measure(options, "visibility_index", instance, 1, [&]() {
+            instance.visibility = nullptr;
+            visibility();
+        }));
+    }
+
+    // earliest arrival of every scheduled communication within one day
+    constexpr float CONTACT_HORIZON = 86400.f; // [sec]
+    if (enabled("contact_plan")) {
+        results.push_back(measure(options, "contact_plan", instance, 1, [&]() {
+            dmsc::ContactPlan plan(physical, *visibility(), CONTACT_HORIZON, options.workers);
+            sink = sink + static_cast<float>(plan.contactCount());
+        }));
+    }
+
+    for (uint32_t hops : {3u, dmsc::ContactPlan::ALL_HOPS}) {
+        std::string name = hops == dmsc::ContactPlan::ALL_HOPS ? "earliest_arrival" : "earliest_arrival_3_hops";
+        const auto& communications = physical.scheduled_communications;
+        if (enabled(name) && !communications.empty()) {
+            dmsc::ContactPlan plan(physical, *visibility(), CONTACT_HORIZON, options.workers);
+            size_t reachable = 0;
+            results.push_back(measure(options, name, instance, communications.size(), [&]() {
+                reachable = 0;
+                for (const auto& c : communications) {
+                    reachable += plan.earliestArrival(c.first, c.second, 0.f, hops) != INFINITY;
+                }
+            }));
+            results.back().counters.push_back({"reachable", static_cast<double>(reachable)});
+        }
+    }
+
+    dmsc::SolverOptions solver_options;
+    solver_options.worker_count = options.workers;
+    // the quality of a solution shows whether an optimization changed the result
+    auto add_solution = [&](const dmsc::DmscSolution& solution) {
+        results.back().counters.push_back({"scanned_edges", static_cast<double>(solution.scan_cover.scanCount())});
+        results.back().counters.push_back({"last_scan", dmsc::scanTime(solution.scan_cover)});
+    };
+
+    if (enabled("greedy_next")) {
+        dmsc::DmscSolution solution;
+        results.push_back(measure(options, "greedy_next", instance, 1, [&]() {
+            solution = dmsc::solver::GreedyNext(instance.physical, visibility(), solver_options).solve();
+        }));
+        add_solution(solution);
+    }
+
+    for (unsigned int k : {0u, 1u, 2u}) {
+        std::string name = "greedy_next_khop_" + std::to_string(k);
+        if (enabled(name)) {
+            dmsc::DmscSolution solution;
+            results.push_back(measure(options, name, instance, 1, [&]() {
+                solution = dmsc::solver::GreedyNextKHop(instance.physical, visibility(), k, solver_options).solve();
+            }));
+            add_solution(solution);
+        }
+    }
+
+    // instance files in both formats
+    const std::pair<const char*, dmsc::InstanceFormat> formats[] = {{"text", dmsc::InstanceFormat::TEXT},
+                                                                   {"binary", dmsc::InstanceFormat::BINARY}};
+    for (const auto& format : formats) {
+        std::string name = std::string("instance_load_") + format.first;
+        if (enabled(name)) {
+            std::string file = "dmsc_bench_" + instance.name + "." + format.first;
+            instance.raw.save(file, format.second);
+            results.push_back(measure(options, name, instance, 1, [&]() {
+                dmsc::Instance loaded(file);
+                sink = sink + static_cast<float>(loaded.edges.size());
+            }));
+            std::remove(file.c_str());
+        }
+    }
+
+    if (enabled("physical_instance_copy")) {
+        results.push_back(measure(options, "physical_instance_copy", instance, 1, [&]() {
+            dmsc::PhysicalInstance copy(physical);
+            sink = sink + static_cast<float>(copy.islCount());
+        }));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void writeJson(FILE* file, const Options& options, const std::vector<Result>& results) {
+#ifdef NDEBUG
+    const char* build = "release";
+#else
+    const char* build = "debug";
+#endif
+    fprintf(file, "{\n  \"context\": {\n");
+    fprintf(file, "    \"build\": \"%s\",\n", build);
+    fprintf(file, "    \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(file, "    \"workers\": %u,\n", options.workers);
+    fprintf(file, "    \"min_time\": %g\n  },\n  \"benchmarks\": [", options.min_time);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"instance\": \"%s\", ", i == 0 ? "" : ",", r.name.c_str(),
+                escape(r.instance).c_str());
+        fprintf(file, "\"satellites\": %zu, \"isls\": %zu, \"iterations\": %zu, \"items_per_iteration\": %zu, ",
+                r.satellites, r.isls, r.iterations, r.items);
+        fprintf(file, "\"ns_per_item\": {\"min\": %.3f, \"median\": %.3f, \"mean\": %.3f}", r.min, r.median, r.mean);
+        if (!r.counters.empty()) {
+            fprintf(file, ", \"counters\": {");
+            for (size_t j = 0; j < r.counters.size(); j++) {
+                fprintf(file, "%s\"%s\": %g", j == 0 ? "" : ", ", r.counters[j].first.c_str(), r.counters[j].second);
+            }
+            fprintf(file, "}");
+        }
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n  ]\n}\n");
+}
+
+// ------------------------------------------------------------------------------------------------
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printf("Missing value for '%s'.\n", arg.c_str());
+            exit(EXIT_FAILURE);
+        }
+        std::string value = argv[++i];
+        if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--instances") {
+            options.instance_dir = value;
+        } else if (arg == "--min-time") {
+            options.min_time = std::atof(value.c_str());
+        } else if (arg == "--workers") {
+            options.workers = static_cast<unsigned int>(std::atoi(value.c_str()));
+        } else if (arg == "--synthetic") {
+            options.synthetic.clear();
+            for (size_t begin = 0; begin < value.size();) {
+                size_t end = std::min(value.find(',', begin), value.size());
+                options.synthetic.push_back(std::strtoull(value.substr(begin, end - begin).c_str(), nullptr, 10));
+                begin = end + 1;
+            }
+        } else {
+            printf("Unknown option '%s'.\n", arg.c_str());
+            exit(EXIT_FAILURE);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    Options options = parseOptions(argc, argv);
+
+    std::vector<BenchInstance> instances;
+    for (const char* name : {"galileo", "iridium_next", "oneweb"}) {
+        dmsc::Instance raw(options.instance_dir + "/" + name + ".csv");
+        if (raw.satellites.empty()) {
+            printf("Instance '%s' could not be loaded from '%s'.\n", name, options.instance_dir.c_str());
+            exit(EXIT_FAILURE);
+        }
+        instances.push_back(prepareInstance(name, std::move(raw)));
+    }
+    for (size_t satellite_count : options.synthetic) {
+        instances.push_back(prepareInstance("walker_" + std::to_string(satellite_count),
+                                            walkerConstellation(satellite_count)));
+    }
+
+    std::vector<Result> results;
+    for (BenchInstance& instance : instances) {
+        runBenchmarks(options, instance, results);
+    }
+
+    FILE* file = options.output.empty() ? stdout : fopen(options.output.c_str(), "w");
+    if (file == nullptr) {
+        printf("Could not open '%s'.\n", options.output.c_str());
+        exit(EXIT_FAILURE);
+    }
+    writeJson(file, options, results);
+    if (file != stdout) {
+        fclose(file);
+    }
+
+    return 0;
+}
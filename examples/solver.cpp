@@ -1,6 +1,7 @@
 #include <dmsc/instance.hpp>
 #include <dmsc/solver.hpp>
 #include <dmsc/visuals.hpp>
+#include <memory>
 
 //===================================
 // Once you defined a problem instance, it is time to solve it. How you gonna solve it, is up to you. Here we want to
@@ -15,8 +16,8 @@
 //===================================
 class SampleSolver : public dmsc::Solver {
   public:
-    SampleSolver(const dmsc::PhysicalInstance& instance)
-        : Solver(instance) {}
+    SampleSolver(std::shared_ptr<const dmsc::PhysicalInstance> instance)
+        : Solver(std::move(instance)) {}
 
     dmsc::DmscSolution solve() {
         // you can access the physical instance
@@ -69,14 +70,16 @@ int main() {
     // 2. solve the instance
     //===================================
 
-    SampleSolver solver(instance);
+    // the physical instance is shared by the solver and the visualization instead of being copied
+    auto physical_instance = std::make_shared<const dmsc::PhysicalInstance>(instance);
+    SampleSolver solver(physical_instance);
     dmsc::DmscSolution solution = solver.solve();
 
     //===================================
     // 3. visualize the solution
     //===================================
 
-    dmsc::visualizeDmscSolution(instance, solution);
+    dmsc::visualizeDmscSolution(physical_instance, solution);
 
     return 0;
 }
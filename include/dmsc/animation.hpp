@@ -3,7 +3,9 @@
 
 #include "glm_include.hpp"
 #include "timeline.hpp"
+#include <cstdint>
 #include <map>
+#include <vector>
 
 namespace dmsc {
 
@@ -45,9 +47,13 @@ struct OrientationDetails {
  *
  */
 struct Animation {
-    std::map<size_t, Timeline<AnimationDetails>> satellites;
-    std::map<size_t, Timeline<AnimationDetails>> intersatellite_links;
-    std::map<size_t, Timeline<OrientationDetails>> satellite_orientations; // TODO ONLY time point; NO interval
+    // animations are usually added in chronological order
+    using AnimationTimeline = Timeline<AnimationDetails, TimelineStorage::SORTED_VECTOR>;
+    using OrientationTimeline = Timeline<OrientationDetails, TimelineStorage::SORTED_VECTOR>;
+
+    std::map<size_t, AnimationTimeline> satellites;
+    std::map<size_t, AnimationTimeline> intersatellite_links;
+    std::map<size_t, OrientationTimeline> satellite_orientations; // TODO ONLY time point; NO interval
 
     bool addSatelliteAnimation(const size_t satellite_idx, const float t_begin, const float t_end,
                                const AnimationDetails& animation);
@@ -55,8 +61,85 @@ struct Animation {
                          const AnimationDetails& animation);
     bool addOrientationAnimation(const size_t satellite_idx, const float t, const OrientationDetails& orientation);
 
-    std::pair<bool, AnimationDetails> getSatelliteAnimation(const size_t satellite_idx, const float t) const;
-    std::pair<bool, AnimationDetails> getISLAnimation(const size_t isl_idx, const float t) const;
+    /**
+     * @brief Returns the animation details of a satellite that are active at time t (first: false, if there are none).
+     * @param cursor optional; speeds up queries with increasing t (see TimelineCursor)
+     */
+    std::pair<bool, AnimationDetails> getSatelliteAnimation(const size_t satellite_idx, const float t,
+                                                            TimelineCursor* cursor = nullptr) const;
+
+    /**
+     * @brief Returns the animation details of an ISL that are active at time t (first: false, if there are none).
+     * @param cursor optional; speeds up queries with increasing t (see TimelineCursor)
+     */
+    std::pair<bool, AnimationDetails> getISLAnimation(const size_t isl_idx, const float t,
+                                                      TimelineCursor* cursor = nullptr) const;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Satellite and ISL animations of an Animation, compiled for playback: the details of all events in one array
+ * and one chronological list of all state changes. seek() applies (or reverts) only the changes between the previous
+ * and the new time, so a frame costs O(changes) - regardless of the number of satellites and ISLs and also for jumps
+ * in either direction. The result is the same as getSatelliteAnimation() and getISLAnimation() at that time.
+ */
+class CompiledAnimation {
+  public:
+    CompiledAnimation() = default;
+
+    /**
+     * @brief Animations of satellites and ISLs with indices beyond the given counts are ignored.
+     */
+    CompiledAnimation(const Animation& animation, const size_t satellite_count, const size_t isl_count);
+
+    /**
+     * @brief Moves the playback to time t. Afterwards changedSatellites() and changedISLs() contain the entities whose
+     * animation changed since the previous call.
+     */
+    void seek(const float t);
+
+    /**
+     * @brief Returns the animation details that are active at the current time; nullptr, if there are none.
+     */
+    const AnimationDetails* getSatelliteAnimation(const size_t satellite_idx) const {
+        return details(state[satellite_idx]);
+    }
+    const AnimationDetails* getISLAnimation(const size_t isl_idx) const {
+        return details(state[satellite_count + isl_idx]);
+    }
+
+    const std::vector<uint32_t>& changedSatellites() const { return changed_satellites; }
+    const std::vector<uint32_t>& changedISLs() const { return changed_isls; }
+
+  private:
+    struct Change {
+        float t = 0.f;       // [sec]
+        uint32_t entity = 0; // satellites first, then ISLs
+        int32_t before = -1; // active event before and after the change (index in events, -1: none)
+        int32_t after = -1;
+        bool strict = false; // applies after t instead of at t (end of an event of length 0)
+
+        bool appliesAt(const float time) const { return strict ? t < time : t <= time; }
+        friend bool operator<(const Change& l, const Change& r) {
+            return l.t < r.t || (l.t == r.t && !l.strict && r.strict);
+        }
+    };
+
+    const AnimationDetails* details(const int32_t event) const {
+        return event < 0 ? nullptr : &events[static_cast<size_t>(event)];
+    }
+    void addChanges(const Animation::AnimationTimeline& timeline, const uint32_t entity);
+    void setState(const uint32_t entity, const int32_t event);
+
+    size_t satellite_count = 0;
+    std::vector<AnimationDetails> events; // details of all events, grouped by entity and in chronological order
+    std::vector<Change> changes;          // chronological
+    size_t applied = 0;                   // changes[0, applied) are applied
+    std::vector<int32_t> state;           // active event of every entity
+    std::vector<unsigned char> changed;   // for every entity: is it part of the changed lists?
+    std::vector<uint32_t> changed_satellites;
+    std::vector<uint32_t> changed_isls;
 };
 
 } // namespace dmsc
@@ -0,0 +1,151 @@
+#ifndef DMSC_CONTACT_PLAN_H
+#define DMSC_CONTACT_PLAN_H
+
+#include "glm_include.hpp"
+#include "instance.hpp"
+#include "visibility_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dmsc {
+
+/**
+ * @brief Visibility windows (contacts) of all ISLs within a fixed horizon and a time-expanded graph over the
+ * satellites on top of them. Unlike the VisibilityIndex, the windows are stored with absolute times, so whether and
+ * when an ISL can be used after a given time is a single binary search. Like the index, the plan never changes after
+ * it was built and can be shared by several solvers.
+ *
+ * The queries only consider the line of sight: the satellites are assumed to be aligned at the beginning of a contact.
+ * Solvers that know the orientations of the satellites can use the cached orientations of the contacts to add the
+ * turn times.
+ */
+class ContactPlan {
+  public:
+    static constexpr uint32_t ALL_HOPS = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NO_ISL = ~0u;
+
+    struct Contact {
+        float t_begin;         // [sec] absolute time
+        float t_end;           // [sec] absolute time, at most the horizon
+        glm::vec3 orientation; // direction of the first satellite of the ISL at t_begin (see getOrientation)
+    };
+
+    /**
+     * @brief Last hop of a route: from the satellite "from" over the ISL at time t.
+     */
+    struct Hop {
+        uint32_t isl_idx = NO_ISL;
+        uint32_t from = ~0u;
+        float t = INFINITY; // [sec]
+    };
+
+    /**
+     * @brief Result of earliestArrivals(): the earliest time at which a message that leaves the source at t0 reaches
+     * every satellite.
+     */
+    class Arrivals {
+      public:
+        /**
+         * @return [sec] Absolute time. INFINITY, if the satellite can't be reached within the horizon (and the hops).
+         */
+        float time(const uint32_t satellite_idx) const { return times[satellite_idx]; }
+        bool isReachable(const uint32_t satellite_idx) const { return times[satellite_idx] != INFINITY; }
+
+        /**
+         * @brief Hops of the earliest route from the source to the given satellite (empty, if it is the source or not
+         * reachable). The times of the hops never decrease.
+         */
+        std::vector<Hop> route(const uint32_t satellite_idx) const;
+
+      private:
+        friend class ContactPlan;
+
+        std::vector<float> times;     // [sec] per satellite
+        std::vector<uint32_t> levels; // hops of the earliest route (0 if the hops are not limited)
+        std::vector<Hop> via;         // last hop per state (satellite, level)
+        uint32_t level_count = 1;
+    };
+
+    ContactPlan() = default;
+
+    /**
+     * @brief Repeats the windows of the visibility index until the horizon and caches the orientations at the
+     * beginning of every contact.
+     * @param horizon [sec] end of the plan; later contacts are unknown to all queries
+     * @param worker_count number of threads used to calculate the orientations (0: all hardware threads)
+     */
+    ContactPlan(const PhysicalInstance& instance, const VisibilityIndex& visibility, const float horizon,
+                const unsigned int worker_count = 1);
+
+    /**
+     * @brief Returns the first contact of the ISL that is active at or after time t. O(log W)
+     * @return nullptr, if the ISL has no more contacts within the horizon.
+     */
+    const Contact* nextContact(const size_t isl_idx, const float t) const;
+
+    /**
+     * @brief Returns the first time (beginning at time t) at which the ISL has line of sight. O(log W)
+     * @return [sec] Absolute time. INFINITY, if the ISL has no more contacts within the horizon.
+     */
+    float nextUsable(const size_t isl_idx, const float t) const {
+        const Contact* contact = nextContact(isl_idx, t);
+        return contact == nullptr ? INFINITY : std::max(t, contact->t_begin);
+    }
+
+    /**
+     * @brief Angle between the given direction of the first (or second) satellite of the ISL and the direction it has
+     * to face at the beginning of the contact.
+     * @return [rad]
+     */
+    static float turnAngle(const Contact& contact, const glm::vec3& direction, const bool second_satellite = false) {
+        float cos_angle = glm::dot(direction, second_satellite ? -contact.orientation : contact.orientation);
+        return std::acos(glm::clamp(cos_angle, -1.f, 1.f));
+    }
+
+    /**
+     * @brief Earliest arrival times of a message that leaves the source at t0 and may wait at every satellite.
+     * Dijkstra-like search over the satellites, every hop costs one binary search in the contacts of an ISL.
+     * @param max_hops limits the number of ISLs per route (e.g. k + 1 for GreedyNextKHop)
+     */
+    Arrivals earliestArrivals(const uint32_t source_idx, const float t0, const uint32_t max_hops = ALL_HOPS) const {
+        return search(source_idx, t0, max_hops, ~0u);
+    }
+
+    /**
+     * @brief Returns the earliest time at which the target can be reached from the source (see earliestArrivals). The
+     * search stops as soon as the target is reached.
+     * @return [sec] Absolute time. INFINITY, if the target can't be reached within the horizon.
+     */
+    float earliestArrival(const uint32_t source_idx, const uint32_t target_idx, const float t0,
+                          const uint32_t max_hops = ALL_HOPS) const {
+        return search(source_idx, t0, max_hops, target_idx).time(target_idx);
+    }
+
+    // GETTER
+    const Contact* contactsBegin(const size_t isl_idx) const { return contacts.data() + offsets[isl_idx]; }
+    const Contact* contactsEnd(const size_t isl_idx) const { return contacts.data() + offsets[isl_idx + 1]; }
+    size_t contactCount(const size_t isl_idx) const { return offsets[isl_idx + 1] - offsets[isl_idx]; }
+    size_t contactCount() const { return contacts.size(); }
+    size_t islCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    float getHorizon() const { return horizon; }
+
+  private:
+    /**
+     * @brief See earliestArrivals(). Stops when the given target is reached, the times of the satellites that were
+     * not reached until then are INFINITY.
+     */
+    Arrivals search(const uint32_t source_idx, const float t0, const uint32_t max_hops,
+                    const uint32_t target_idx) const;
+
+    float horizon = 0.f;           // [sec]
+    std::vector<uint32_t> offsets; // contacts of ISL i are in [offsets[i], offsets[i + 1])
+    std::vector<Contact> contacts; // sorted by ISL and time
+    AdjacencyList graph;           // satellites and their ISLs (see PhysicalInstance::getAdjacencyMatrix)
+};
+
+} // namespace dmsc
+
+#endif
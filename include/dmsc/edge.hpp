@@ -4,10 +4,13 @@
 #include "dmsc/glm_include.hpp"
 #include "satellite.hpp"
 #include "timeline.hpp"
+#include <utility>
 #include <vector>
 
 namespace dmsc {
 
+constexpr float ALIGNMENT_TOLERANCE = 1e-3f; // [rad] see InterSatelliteLink::earliestAlignment()
+
 /**
  * @brief Bidirectional intersatellite link between two satellites A and B.
  */
@@ -17,8 +20,17 @@ class InterSatelliteLink {
     const Satellite* v2;
     uint32_t v1_idx;
     uint32_t v2_idx;
-    float period;   // [sec] time until satellite constellations repeat
-    CentralMass cm; // properties of the central mass
+    float period;    // [sec] time until satellite constellations repeat
+    float max_speed; // [km/sec] upper bound for the speed of both satellites (speed at perigee)
+    CentralMass cm;  // properties of the central mass
+
+    /**
+     * @brief Searches for the first time in [t0, t_max] where the visibility of this edge equals the given state.
+     * @return first: last time found with the opposite state; second: first time found with the given state. Both
+     * values are INFINITY if there is no such time.
+     */
+    std::pair<float, float> findVisibilityState(const float t0, const float t_max, const float min_step,
+                                                const bool visible) const;
 
   public:
     /**
@@ -37,6 +49,56 @@ class InterSatelliteLink {
      */
     bool isBlocked(const float time) const;
 
+    /**
+     * @brief Returns true, if the line of sight between the given satellite positions is blocked by the central mass.
+     * Useful if the positions are already known (e.g. from the ConstellationPropagator).
+     */
+    bool isBlocked(const glm::vec3& sat1, const glm::vec3& sat2) const { return clearance(sat1, sat2) <= 0.f; }
+
+    /**
+     * @brief Distance between the line of sight and the surface of the central mass. The value is negative, if the line
+     * of sight intersects the central mass (i.e. the edge is blocked).
+     * The distance changes continuously over time and no faster than the satellites move. Visibility windows can
+     * therefore be found by root finding instead of checking every time step.
+     *
+     * @param time [sec]
+     * @return [km] (signed) distance
+     */
+    float clearance(const float time) const;
+
+    /**
+     * @brief Clearance for the given positions of the first and second satellite. See clearance(time).
+     */
+    float clearance(const glm::vec3& sat1, const glm::vec3& sat2) const {
+        return clearance(sat1, sat2, cm.radius_central_mass);
+    }
+
+    /**
+     * @brief Clearance for the given positions and a central mass with the given radius [km]. Useful to check pairs of
+     * satellites that are not connected by an ISL (yet).
+     */
+    static float clearance(const glm::vec3& sat1, const glm::vec3& sat2, const float radius_central_mass);
+
+    /**
+     * @brief Returns the first time in [t0, t_max] when the edge is visible. The time steps between two evaluations
+     * depend on the current distance to the central mass and are at least min_step seconds. The edge of the visibility
+     * window is then refined by bisection.
+     *
+     * @param min_step [sec] Minimal step size. Visibility windows shorter than this might be missed.
+     * @return [sec] Absolute time. INFINITY if the edge is not visible until t_max.
+     */
+    float nextVisible(const float t0, const float t_max, const float min_step = 1.0f) const;
+
+    /**
+     * @brief Returns the last time in [t0, t_max] when the edge is visible before it gets blocked by the central mass.
+     * See nextVisible() for details about the search.
+     *
+     * @param min_step [sec] Minimal step size. Blocked intervals shorter than this might be missed.
+     * @return [sec] Absolute time. INFINITY if the edge is not blocked until t_max. If the edge is already blocked at
+     * t0, t0 is returned.
+     */
+    float lastVisible(const float t0, const float t_max, const float min_step = 1.0f) const;
+
     /**
      * @brief Returns true, if there is enough time for both satellites to face each other at the given time.
      *
@@ -46,6 +108,19 @@ class InterSatelliteLink {
      */
     bool canAlign(const TimelineEvent<glm::vec3>& sat1, const TimelineEvent<glm::vec3>& sat2, const float t) const;
 
+    /**
+     * @brief Lower bound for the first time (beginning at time t) when both satellites can face each other. The
+     * satellites can't align in [t, result), so a search for the next communication may skip this interval.
+     * The bound uses the maximal speed of both satellites to limit how fast the line of sight can rotate. Angles that
+     * differ by less than ALIGNMENT_TOLERANCE are treated as equal, so rounding errors never skip a valid time.
+     *
+     * @param sat1 & sat 2 see canAlign()
+     * @param t [sec] time of the last check
+     * @return [sec] Absolute time. The given time, if the satellites might be able to align at t.
+     */
+    float earliestAlignment(const TimelineEvent<glm::vec3>& sat1, const TimelineEvent<glm::vec3>& sat2,
+                            const float t) const;
+
     /**
      * @brief Calculate the directions for both satellites to face each other. Because both satellites have to face each
      * other, the direction of satellite A is the negative direction of satellite B.
@@ -9,6 +9,8 @@
 
 namespace dmsc {
 
+class VisibilityIndex; // see visibility_index.hpp
+
 /// Indices of two satellites that are supposed to communicate.
 using ScheduledCommunication = std::pair<uint32_t, uint32_t>;
 
@@ -18,7 +20,8 @@ using ScheduledCommunication = std::pair<uint32_t, uint32_t>;
  * @brief Adjacency list that describes which satellites can communicate with each other and at what costs.
  *
  * Instead of an adjacency matrix, we use an adjacency list to avoid superfluous entries and thus significantly reduce
- * memory consumption. In order to still be able to access elements directly, we store the data of each row in a map.
+ * memory consumption. All entries are stored in one array, sorted by row and column (compressed sparse row). The
+ * entries of a row are found by an offset table, a single element by binary search within its row.
  */
 class AdjacencyList {
   public:
@@ -35,16 +38,82 @@ class AdjacencyList {
     };
 
     /**
-     * @brief In order to be able to access elements directly (like an adjacency matrix), we store the data of each
-     * row in a map instead of a list. This way we can acces elements by matrix[row][column].
+     * @brief Element at matrix[row][column].
+     */
+    struct Entry {
+        uint32_t row = ~0u;
+        uint32_t column = ~0u;
+        Item item;
+        Entry() = default;
+        Entry(const uint32_t row, const uint32_t column, const Item& item)
+            : row(row)
+            , column(column)
+            , item(item) {}
+
+        bool operator<(const Entry& e) const { return row < e.row || (row == e.row && column < e.column); }
+    };
+
+    /**
+     * @brief View of all entries of one row (sorted by column). Only valid as long as the adjacency list exists.
+     */
+    class Row {
+      public:
+        Row() = default;
+        Row(const Entry* first, const Entry* last)
+            : first(first)
+            , last(last) {}
+
+        const Entry* begin() const { return first; }
+        const Entry* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+
+        /**
+         * @brief Returns the entry of the given column or end() if there is none. O(log d)
+         */
+        const Entry* find(const uint32_t column) const;
+
+      private:
+        const Entry* first = nullptr;
+        const Entry* last = nullptr;
+    };
+
+    AdjacencyList() = default;
+
+    /**
+     * @brief Builds the adjacency list from entries in any order. If an element occurs more than once, the last one
+     * is used (like assigning it several times).
+     * @param row_count number of rows (i.e. satellites)
      */
-    std::vector<std::map<uint32_t, Item>> matrix;
+    AdjacencyList(const size_t row_count, std::vector<Entry> entries);
 
-    AdjacencyList() = delete;
-    AdjacencyList(const size_t size, const Item& default_value);
-    std::map<uint32_t, Item>& operator[](size_t row) { return matrix[row]; }
-    const std::map<uint32_t, Item>& operator[](size_t row) const { return matrix[row]; }
+    /**
+     * @brief Returns all entries of the given row. O(1)
+     */
+    Row operator[](size_t row) const { return Row(entries.data() + offsets[row], entries.data() + offsets[row + 1]); }
+
+    size_t rowCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t entryCount() const { return entries.size(); }
+
+    /**
+     * @brief Position of an entry (returned by operator[]) in [0, entryCount()), e.g. to mark entries in a bitset.
+     */
+    size_t entryIndex(const Entry& entry) const { return &entry - entries.data(); }
     void clear();
+
+    /**
+     * @brief Sorts the entries by row and column and removes duplicates (the last one is kept).
+     */
+    static void sortEntries(std::vector<Entry>& entries);
+
+    /**
+     * @brief Finds all entries of a row in entries sorted by sortEntries() - without offset table. O(log n)
+     */
+    static Row findRow(const std::vector<Entry>& sorted_entries, const uint32_t row);
+
+  private:
+    std::vector<uint32_t> offsets; // entries of row i are in [offsets[i], offsets[i + 1])
+    std::vector<Entry> entries;    // sorted by row and column
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -75,6 +144,17 @@ struct Edge {
 
 // ------------------------------------------------------------------------------------------------
 
+/**
+ * @brief File formats of an instance. Binary files are smaller and are loaded without parsing, but they use the byte
+ * order of the machine that created them.
+ */
+enum class InstanceFormat {
+    TEXT,   // human-readable blocks of ';' separated values
+    BINARY, // header followed by packed arrays of all satellites and edges
+};
+
+// ------------------------------------------------------------------------------------------------
+
 /**
  * @brief Contains all necessary data for the movement of satellites and the graphs that define the connections between
  * satellites. No additional calculations are performed. You can change everything anytime you want.
@@ -92,7 +172,8 @@ struct Instance {
     Instance() = default;
 
     /**
-     * @brief Construct a new Instance object from a given file.
+     * @brief Construct a new Instance object from a given file. The format (see InstanceFormat) is detected
+     * automatically.
      *
      * @param file Path to file where the instance is stored.
      */
@@ -102,11 +183,26 @@ struct Instance {
      * @brief Save the instance to the given file.
      *
      * @param file Path to the location where the instance should be saved.
+     * @param format The text format doesn't contain the cone angles of the satellites.
      */
-    void save(const std::string& file) const;
+    void save(const std::string& file, const InstanceFormat format = InstanceFormat::TEXT) const;
 
   private:
     enum FileReadingMode { READ_INIT, READ_ORBIT, READ_EDGE }; // order must match blocks in file-format
+
+    /**
+     * @brief Reads an instance in the text format. Invalid lines are skipped.
+     */
+    void loadText(const char* data, const size_t size, const std::string& file);
+
+    /**
+     * @brief Reads an instance in the binary format.
+     * @return false, if the data is no valid binary instance (the instance stays empty).
+     */
+    bool loadBinary(const char* data, const size_t size, const std::string& file);
+
+    void saveText(const std::string& file) const;
+    void saveBinary(const std::string& file) const;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -123,11 +219,35 @@ class PhysicalInstance {
     PhysicalInstance(const PhysicalInstance& source);
     PhysicalInstance& operator=(const PhysicalInstance& source);
 
+    // A moved vector keeps its buffer, so the satellite pointers of the ISLs stay valid without rebuilding the edges.
+    PhysicalInstance(PhysicalInstance&& source) noexcept = default;
+    PhysicalInstance& operator=(PhysicalInstance&& source) noexcept = default;
+
     /**
      * @brief Removes all intersatellite links that will never be visible. I.e. if an ISL is always blocked by the
-     * central mass, it will be removed.
+     * central mass, it will be removed. The visibility is found by root finding (see InterSatelliteLink::nextVisible).
+     *
+     * @param worker_count number of threads used to check the ISLs (0: all hardware threads)
+     * @return New index for every old ISL index (~0u for removed ISLs), e.g. to translate a ScanCover.
      */
-    void removeInvalidISL();
+    std::vector<uint32_t> removeInvalidISL(const unsigned int worker_count = 1);
+
+    /**
+     * @brief Same as removeInvalidISL(), but uses the visibility windows of a visibility index that was built for this
+     * instance instead of searching them again. The index doesn't match the instance anymore afterwards.
+     */
+    std::vector<uint32_t> removeInvalidISL(const VisibilityIndex& visibility);
+
+    /**
+     * @brief Adds an intersatellite link for every pair of satellites that is at most max_range apart and not blocked
+     * by the central mass at one of the sampled times at least. Pairs that are already connected are skipped.
+     * The positions are sampled uniformly within the longest orbital period and sorted into a uniform grid with a cell
+     * size of max_range, so only satellites in neighbouring cells are compared (O(N log N) per sample).
+     *
+     * @param max_range [km] maximal distance between two satellites
+     * @param sample_count number of sampled times. Pairs that are only briefly in range might be missed.
+     */
+    void addCandidateISLs(const float max_range, const size_t sample_count = 64);
 
     // ISLs are stored in an adjacency list; scheduled communications are stored in this vector
     std::vector<ScheduledCommunication> scheduled_communications;
@@ -143,11 +263,17 @@ class PhysicalInstance {
   private:
     std::vector<Satellite> satellites;
     std::vector<InterSatelliteLink> intersatellite_links;
-    AdjacencyList adjacency_list = AdjacencyList(0, AdjacencyList::Item(~0u, ~0u));
+    AdjacencyList adjacency_list;
     CentralMass cm;
     enum FileReadingMode { READ_INIT, READ_ORBIT, READ_EDGE }; // order must match blocks in file-format
 
     void buildAdjacencyMatrix();
+
+    /**
+     * @brief Removes all ISLs with keep[i] == 0 in a single pass (the order of the others is unchanged).
+     * @return see removeInvalidISL()
+     */
+    std::vector<uint32_t> removeISLs(const std::vector<unsigned char>& keep);
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+#ifndef DMSC_KEPLER_H
+#define DMSC_KEPLER_H
+
+#include <cstddef>
+
+namespace dmsc {
+
+/**
+ * Accuracy contract of the Kepler equation solver (M = E - e * sin(E)):
+ * For 0 <= e <= 0.9 the returned eccentric anomaly differs by at most KEPLER_TOLERANCE [rad] from the exact solution
+ * of the (float) mean anomaly. Up to e = 0.99 the error stays below 5 * KEPLER_TOLERANCE, since the equation is badly
+ * conditioned near the periapsis. Larger eccentricities are not covered.
+ * The solver performs at most KEPLER_ITERATIONS Halley steps starting at Danby's initial guess.
+ */
+constexpr float KEPLER_TOLERANCE = 1e-6f;
+constexpr int KEPLER_ITERATIONS = 4;
+
+/**
+ * @brief Solves the Kepler equation.
+ * @param mean_anomaly [rad] any value (|M| < 1e5)
+ * @param eccentricity in [0, 1)
+ * @return [rad] eccentric anomaly in [-pi, pi]
+ */
+float eccentricAnomaly(const float mean_anomaly, const float eccentricity);
+
+/**
+ * @brief Solves the Kepler equation for n (mean anomaly, eccentricity) pairs, e.g. many satellites or times.
+ * Always performs KEPLER_ITERATIONS steps, so the loop has no branches and is vectorized by the compiler. The results
+ * can differ from the scalar version within the tolerance.
+ */
+void eccentricAnomaly(const size_t n, const float* mean_anomaly, const float* eccentricity, float* eccentric_anomaly);
+
+} // namespace dmsc
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef DMSC_PROPAGATOR_H
+#define DMSC_PROPAGATOR_H
+
+#include "dmsc/glm_include.hpp"
+#include "satellite.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace dmsc {
+
+/**
+ * @brief Calculates the positions of all satellites of a constellation at once.
+ *
+ * The orbital elements are stored as structure of arrays together with all terms that do not depend on the time (e.g.
+ * the basis of the orbital plane). A position then only needs one sine and cosine of the true (circular orbits) or
+ * eccentric anomaly (elliptical orbits). The loops contain no branches and use a polynomial approximation of
+ * sine/cosine, so the compiler can vectorize them (e.g. AVX2 or NEON - depending on the target architecture).
+ *
+ * The positions match Satellite::cartesian_coordinates up to float rounding errors of the angles. These grow with the
+ * time (relative error of about 1e-4 after 1e6 seconds).
+ */
+class ConstellationPropagator {
+  public:
+    ConstellationPropagator() = default;
+
+    /**
+     * @param satellites The positions are returned in the same order.
+     */
+    explicit ConstellationPropagator(const std::vector<Satellite>& satellites);
+
+    /**
+     * @brief Calculates the positions of all satellites at the given time.
+     * @param time [sec]
+     * @param positions Is resized to the number of satellites. Element i is the position of satellite i.
+     */
+    void propagate(const float time, std::vector<glm::vec3>& positions) const;
+
+    /**
+     * @brief Calculates the positions of all satellites at all given times (N x T block).
+     * @param times [sec]
+     * @param positions Is resized to N * T elements. The position of satellite i at time times[j] is positions[i * T
+     * + j].
+     */
+    void propagate(const std::vector<float>& times, std::vector<glm::vec3>& positions) const;
+
+    /**
+     * @brief Orbital elements of all satellites in the layout of resources/shader/orbit.glsl, so the positions can be
+     * calculated in a shader. Three texels per satellite:
+     * - (semi-major axis, semi-minor axis, eccentricity, mean angular speed)
+     * - (p, anomaly at time 0)
+     * - (q, 0)
+     */
+    std::vector<glm::vec4> packElements() const;
+
+    size_t size() const { return radius.size(); }
+
+  private:
+    /**
+     * @brief Positions of all satellites on circular orbits. The position of the i-th satellite is written to
+     * out[i * stride].
+     */
+    void propagateCircular(const float time, glm::vec3* out, const size_t stride) const;
+
+    /**
+     * @brief Positions of all satellites on elliptical orbits. See propagateCircular.
+     */
+    void propagateElliptical(const float time, glm::vec3* out, const size_t stride) const;
+
+    // per satellite
+    std::vector<float> radius;               // [km] semi-major axis
+    std::vector<float> initial_true_anomaly; // [rad] only used for circular orbits
+    std::vector<float> mean_angular_speed;   // [rad / sec]
+    std::vector<float> px, py, pz;           // orbital plane: position = r * (cos(true_anomaly) * p + sin() * q)
+    std::vector<float> qx, qy, qz;
+
+    // satellites on elliptical orbits
+    std::vector<uint32_t> elliptical_idx;
+    std::vector<float> eccentricity;
+    std::vector<float> semi_minor_axis; // [km]
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Precomputed positions of all satellites within one period. A position is interpolated from the four nearest
+ * samples of its orbit (Catmull-Rom spline), so no trigonometric function or Kepler equation has to be solved.
+ *
+ * The table is meant for the visualization: the interpolation error decreases with the 3rd power of the samples per
+ * orbit (on a low earth orbit about 1 km with 32 samples and 0.03 km with 128 samples). Compared with the
+ * ConstellationPropagator, it mainly pays off for elliptical orbits (about 3 times faster for 10k satellites).
+ */
+class OrbitTable {
+  public:
+    OrbitTable() = default;
+
+    /**
+     * @param satellites The positions are returned in the same order.
+     * @param samples_per_orbit Number of positions stored for each satellite (at least 4).
+     */
+    OrbitTable(const std::vector<Satellite>& satellites, const unsigned int samples_per_orbit = 128);
+
+    /**
+     * @brief Interpolates the positions of all satellites at the given time.
+     * @param time [sec]
+     * @param positions Is resized to the number of satellites. Element i is the position of satellite i.
+     */
+    void interpolate(const float time, std::vector<glm::vec3>& positions) const;
+
+    size_t size() const { return period.size(); }
+    unsigned int getSamplesPerOrbit() const { return samples; }
+
+  private:
+    unsigned int samples = 0;       // per orbit
+    std::vector<float> period;      // [sec]
+    std::vector<float> sample_rate; // [1 / sec] samples / period
+    std::vector<glm::vec3> table;   // (samples + 3) positions per satellite: sample -1, 0, ..., samples + 1
+};
+
+} // namespace dmsc
+
+#endif
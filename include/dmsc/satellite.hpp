@@ -60,6 +60,8 @@ class Satellite {
     float period;             // [sec] time required for one revolution around the central mass
     float mean_angular_speed; // [rad / sec]
     float semi_major_axis;    // [km] semi-major axis of the ellipse that describes the orbit of the satellite
+    float semi_latus_rectum;  // [km] a * (1 - e^2)
+    float anomaly_factor;     // sqrt((1 + e) / (1 - e)) to convert the eccentric into the true anomaly
 
   public:
     /**
@@ -80,6 +82,7 @@ class Satellite {
 
     /**
      * @brief Transforms a satellite position into 3D cartesian coordinates.
+     * For elliptical orbits the eccentric anomaly is found by eccentricAnomaly() (see kepler.hpp for its accuracy).
      * z-axis: vernal point; y-axis: up-direction; x-axis: normal
      * @param time [sec] Determines satellite position in orbit.
      * @return (x, y, z) coordinates
@@ -89,6 +92,7 @@ class Satellite {
     // GETTER
     float getPeriod() const { return period; }
     float getSemiMajorAxis() const { return semi_major_axis; }
+    float getMeanAngularSpeed() const { return mean_angular_speed; }
     float getEccentricity() const { return sv.eccentricity; }
     float getRotationSpeed() const { return sv.rotation_speed; }
     float getTrueAnomaly() const { return sv.initial_true_anomaly; }
@@ -0,0 +1,219 @@
+#ifndef DMSC_SCAN_COVER_H
+#define DMSC_SCAN_COVER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dmsc {
+
+namespace tools {
+class MappedFile; // see mapped_file.hpp
+} // namespace tools
+
+/** Scan cover file format (native byte order):
+ *
+ * ScanCoverHeader
+ * chunks of chunk_size scans (the last one may be shorter), each chunk with n scans:
+ *   uint32_t edge_idx[n];
+ *   float t[n];
+ *
+ * The scans are sorted by time, so files can be written while the scans are found and read in time order.
+ */
+struct ScanCoverHeader {
+    char magic[8] = {'D', 'M', 'S', 'C', 'S', 'C', 'N', '\0'};
+    uint32_t version = 1u;
+    uint32_t chunk_size = 0u; // scans per chunk
+    uint64_t scan_count = 0u;
+};
+static_assert(sizeof(ScanCoverHeader) == 24, "The scan cover header must not contain padding bytes.");
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Writes scans in chunks into a scan cover file. Only the current chunk is kept in memory. The scans have to be
+ * added in chronological order.
+ */
+class ScanCoverWriter {
+  public:
+    static constexpr uint32_t DEFAULT_CHUNK_SIZE = 1u << 16;
+
+    /**
+     * @brief Creates (or overwrites) the given file.
+     */
+    explicit ScanCoverWriter(const std::string& file, const uint32_t chunk_size = DEFAULT_CHUNK_SIZE);
+    ~ScanCoverWriter() { close(); }
+    ScanCoverWriter(const ScanCoverWriter&) = delete;
+    ScanCoverWriter& operator=(const ScanCoverWriter&) = delete;
+
+    /**
+     * @param t [sec] at least the time of the previous scan
+     */
+    void add(const uint32_t edge_idx, const float t);
+
+    /**
+     * @brief Writes the last chunk and the number of scans. Called by the destructor, if it was not called before.
+     */
+    void close();
+
+    uint64_t scanCount() const { return header.scan_count; }
+    float lastTime() const { return last_time; }
+    const std::string& getFile() const { return file_name; }
+
+  private:
+    void writeChunk();
+
+    std::string file_name;
+    FILE* file = nullptr;
+    ScanCoverHeader header;
+    std::vector<uint32_t> edges; // current chunk
+    std::vector<float> times;    // current chunk
+    float last_time = 0.f;       // [sec]
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Edges and the times at which they are scanned, sorted by time (scans at the same time in the order they were
+ * added). The scans are stored as two contiguous arrays.
+ *
+ * As long as the scans are added in chronological order (as the solvers do), adding a scan is O(1). The scans can also
+ * be spilled into a file (see spill()), so only the last chunk is kept in memory.
+ */
+class ScanCover {
+  public:
+    ScanCover() = default;
+    ~ScanCover() { finishSpill(); }
+
+    /**
+     * @brief Copies the scans (and the file of a finished spill). A scan cover that is still spilling can only be
+     * moved, because the file can only have one writer.
+     */
+    ScanCover(const ScanCover& other);
+    ScanCover& operator=(const ScanCover& other);
+    ScanCover(ScanCover&& other) noexcept = default;
+    ScanCover& operator=(ScanCover&& other) noexcept;
+
+    /**
+     * @brief Adds a scan of the edge with the given index.
+     * @param t [sec] Time of the scan. If spilling, at least the time of the previous scan. Not allowed after
+     * finishSpill() (until clear()).
+     */
+    void add(const uint32_t edge_idx, const float t);
+
+    /**
+     * @brief From now on, all scans are written in chunks into the given file instead of being kept in memory. The
+     * scans added before are written first.
+     */
+    void spill(const std::string& file, const uint32_t chunk_size = ScanCoverWriter::DEFAULT_CHUNK_SIZE);
+
+    /**
+     * @brief Finishes the file of spill(). Called by the destructor. Afterwards, the scan cover is empty but still
+     * knows the file, the number of scans and the time of the last scan (e.g. for MappedScanCover). No scans can be
+     * added until clear().
+     */
+    void finishSpill();
+
+    /**
+     * @brief Writes all scans (in memory) into a scan cover file.
+     */
+    void save(const std::string& file) const;
+
+    /**
+     * @brief Loads a scan cover file into memory.
+     * @return false, if the file does not exist or is invalid.
+     */
+    bool load(const std::string& file);
+
+    void reserve(const size_t n) {
+        edges.reserve(n);
+        times.reserve(n);
+    }
+    /**
+     * @brief Removes all scans and forgets the spill file (the file itself is kept).
+     */
+    void clear();
+
+    // GETTER
+    size_t size() const { return edges.size(); } // scans in memory
+    bool empty() const { return edges.empty(); }
+    uint32_t edgeIdx(const size_t i) const { return edges[i]; }
+    float time(const size_t i) const { return times[i]; }
+    const std::vector<uint32_t>& getEdges() const { return edges; }
+    const std::vector<float>& getTimes() const { return times; }
+
+    uint64_t scanCount() const { return spilled_count + edges.size(); } // including the spilled scans
+    float lastTime() const { return times.empty() ? spilled_last_time : times.back(); }
+    bool isSpilled() const { return !spill_file.empty(); }
+    const std::string& getSpillFile() const { return spill_file; }
+
+  private:
+    void spillChunk();
+    void copyFrom(const ScanCover& other);
+
+    std::vector<uint32_t> edges;
+    std::vector<float> times; // [sec] sorted
+
+    std::string spill_file;                  // see spill()
+    std::unique_ptr<ScanCoverWriter> writer; // while spilling
+    uint32_t spill_chunk_size = 0;
+    uint64_t spilled_count = 0;
+    float spilled_last_time = 0.f; // [sec]
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Read-only view of a scan cover file without loading it into memory. On POSIX systems the file is
+ * memory-mapped, so only the pages of the scans that are read are loaded.
+ */
+class MappedScanCover {
+  public:
+    MappedScanCover();
+    ~MappedScanCover();
+    MappedScanCover(const MappedScanCover&) = delete;
+    MappedScanCover& operator=(const MappedScanCover&) = delete;
+
+    /**
+     * @return false, if the file does not exist or is invalid.
+     */
+    bool open(const std::string& file);
+    void close();
+
+    size_t size() const { return static_cast<size_t>(scan_count); }
+    bool empty() const { return scan_count == 0; }
+
+    uint32_t edgeIdx(const size_t i) const {
+        uint32_t edge_idx;
+        std::memcpy(&edge_idx, chunk(i) + sizeof(uint32_t) * (i % chunk_size), sizeof(edge_idx));
+        return edge_idx;
+    }
+
+    float time(const size_t i) const {
+        float t;
+        std::memcpy(&t, chunk(i) + sizeof(uint32_t) * chunkLength(i) + sizeof(float) * (i % chunk_size), sizeof(t));
+        return t;
+    }
+
+  private:
+    const char* chunk(const size_t i) const { return scans + (i / chunk_size) * chunk_size * CHUNK_SCAN_SIZE; }
+
+    size_t chunkLength(const size_t i) const {
+        size_t first = (i / chunk_size) * chunk_size;
+        return scan_count - first < chunk_size ? static_cast<size_t>(scan_count - first) : chunk_size;
+    }
+
+    static constexpr size_t CHUNK_SCAN_SIZE = sizeof(uint32_t) + sizeof(float); // [byte] per scan
+
+    std::unique_ptr<tools::MappedFile> mapped_file;
+    const char* scans = nullptr; // first chunk
+    size_t chunk_size = 1;
+    uint64_t scan_count = 0;
+};
+
+} // namespace dmsc
+
+#endif
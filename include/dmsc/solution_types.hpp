@@ -1,13 +1,20 @@
 #ifndef DMSC_SOLUTION_TYPES_H
 #define DMSC_SOLUTION_TYPES_H
 
-#include <map>
+#include "scan_cover.hpp"
+#include "solver_stats.hpp"
+#include <algorithm>
 #include <vector>
 
 namespace dmsc {
 
-/// index of an edge and the time when this edge is scanned - time in [sec]
-using ScanCover = std::multimap<uint32_t, float>;
+/**
+ * @brief Time of the last scan (makespan) of the given scan cover, including spilled scans.
+ * @return [sec] 0, if the scan cover is empty.
+ */
+inline float scanTime(const ScanCover& scan_cover) {
+    return scan_cover.scanCount() > 0 ? std::max(0.f, scan_cover.lastTime()) : 0.f;
+}
 
 // ------------------------------------------------------------------------------------------------
 
@@ -19,6 +26,8 @@ struct DmscSolution {
     float computation_time = 0.f; // [sec]
     float scan_time = 0.f;        // [sec]
     ScanCover scan_cover;
+    SolverStats stats;      // how the computation time was spent
+    bool cancelled = false; // the solver was stopped (see SolverOptions::cancel), so the scan cover is incomplete
 
     /**
      * @brief The edge with the given index will be scanned at the given time.
@@ -26,7 +35,7 @@ struct DmscSolution {
      * @param edge_idx Index of edge in the underlying physical instance.
      * @param time [sec]
      */
-    void scheduleEdge(const uint32_t edge_idx, const float time) { scan_cover.insert({edge_idx, time}); }
+    void scheduleEdge(const uint32_t edge_idx, const float time) { scan_cover.add(edge_idx, time); }
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -39,6 +48,7 @@ struct FreezeTagSolution {
     float computation_time = 0.f; // [sec]
     float scan_time = 0.f;        // [sec]
     ScanCover scan_cover;
+    SolverStats stats; // how the computation time was spent
     std::vector<size_t> satellites_with_message; // initial satellites
 
     /**
@@ -47,7 +57,7 @@ struct FreezeTagSolution {
      * @param edge_idx Index of edge in the underlying physical instance.
      * @param time [sec]
      */
-    void scheduleEdge(const uint32_t edge_idx, const float time) { scan_cover.insert({edge_idx, time}); }
+    void scheduleEdge(const uint32_t edge_idx, const float time) { scan_cover.add(edge_idx, time); }
 };
 
 } // namespace dmsc
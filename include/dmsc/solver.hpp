@@ -3,60 +3,177 @@
 
 #include "instance.hpp"
 #include "satellite.hpp"
+#include "solver_stats.hpp"
 #include "timeline.hpp"
-#include <map>
+#include "visibility_index.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace dmsc {
 
+/**
+ * @brief Settings that only affect how fast a solver evaluates an instance - not the solution itself.
+ */
+struct SolverOptions {
+    // number of threads used to build the visibility index and by solvers that evaluate edges in parallel (0: all
+    // hardware threads)
+    unsigned int worker_count = 1;
+
+    /**
+     * If set, the visibility cache is loaded from this file instead of being calculated. If the file does not exist
+     * or was created for a different instance, the cache is calculated and the file is (over)written.
+     */
+    std::string cache_file = "";
+
+    /**
+     * If set, every solve() writes the measured scopes (see SolverStats) in the Chrome trace format to this file (e.g.
+     * for chrome://tracing or https://ui.perfetto.dev). Requires the CMake option DMSC_ENABLE_STATS.
+     */
+    std::string trace_file = "";
+
+    /**
+     * If set, solve() spills the scan cover into this file while it is computed (see ScanCover::spill), so only the
+     * last chunk of scans is kept in memory. The returned scan cover is empty but refers to the file (e.g. for
+     * MappedScanCover or OpenGLWidget::show).
+     */
+    std::string scan_cover_file = "";
+
+    /**
+     * If set, solve() checks this flag after every scheduled edge and returns the incomplete solution (see
+     * DmscSolution::cancelled) as soon as it is true. The flag may be set from any thread.
+     */
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Last known orientation for each satellite (same index as in the instance) and the time when it changed.
+ * Invalid events mark satellites that were not oriented yet. Every solver has its own state, so solvers that share a
+ * VisibilityIndex can run on different threads.
+ */
+class OrientationState {
+  public:
+    OrientationState() = default;
+    explicit OrientationState(const size_t satellite_count) { reset(satellite_count); }
+
+    /**
+     * @brief Forgets the orientations of all satellites.
+     */
+    void reset(const size_t satellite_count) { orientations.assign(satellite_count, TimelineEvent<glm::vec3>()); }
+
+    /**
+     * @brief Both satellites of the given ISL face each other from the given time on.
+     */
+    void orient(const InterSatelliteLink& isl, const float t) {
+        glm::vec3 new_orientation = isl.getOrientation(t);
+        orientations[isl.getV1Idx()] = TimelineEvent<glm::vec3>(t, t, new_orientation);
+        orientations[isl.getV2Idx()] = TimelineEvent<glm::vec3>(t, t, -new_orientation);
+    }
+
+    const TimelineEvent<glm::vec3>& operator[](const size_t satellite_idx) const { return orientations[satellite_idx]; }
+    size_t size() const { return orientations.size(); }
+
+  private:
+    std::vector<TimelineEvent<glm::vec3>> orientations;
+};
+
+// ------------------------------------------------------------------------------------------------
+
 class Solver {
   public:
-    Solver(const PhysicalInstance& instance)
-        : instance(instance) {
-        createCache();
-    };
+    /**
+     * @brief Copies the given instance and builds a new visibility index for it (see SolverOptions).
+     */
+    Solver(const PhysicalInstance& instance, const SolverOptions& options = SolverOptions());
+
+    /**
+     * @brief Shares the given instance instead of copying it and builds a new visibility index for it.
+     */
+    Solver(std::shared_ptr<const PhysicalInstance> instance, const SolverOptions& options = SolverOptions());
+
+    /**
+     * @brief Uses an existing instance and visibility index (e.g. of another solver) instead of copying and building
+     * them. options.cache_file is ignored.
+     */
+    Solver(std::shared_ptr<const PhysicalInstance> instance, std::shared_ptr<const VisibilityIndex> visibility,
+           const SolverOptions& options = SolverOptions());
+
+    /**
+     * @brief The instance of this solver. It can be shared with other solvers or the visualization.
+     */
+    std::shared_ptr<const PhysicalInstance> getInstance() const { return shared_instance; }
+
+    /**
+     * @brief The visibility index of this solver. It can be shared with other solvers for the same instance.
+     */
+    std::shared_ptr<const VisibilityIndex> getVisibilityIndex() const { return visibility; }
 
   protected:
     /**
      * @brief Calculates the time (beginning at time x) when an egde can be scanned the next time.
-     * The central mass and turn costs are considered.
+     * The central mass and turn costs are considered. Valid results are multiples of the step size or the beginning of
+     * a visibility window. As long as the orientations of both satellites don't change, the result is the same for
+     * every start time between time_0 and the result.
      * @param time_0 [sec] start time
      * @return Absolute time in [sec] for next communication possible.
      */
-    float nextCommunication(const InterSatelliteLink& edge, const float time_0);
+    float nextCommunication(const InterSatelliteLink& edge, const float time_0) const {
+        return nextCommunication(edge, time_0, satellite_orientation);
+    }
 
-    /** Returns the time when the edge is visible for next time beginning at time t0.
-     * If the corresponding time slot was evalutated before - use the cached version to reduce computation
-     * time.
+    /**
+     * @brief Same as nextCommunication(edge, time_0), but for the given orientations. Only reads the visibility index,
+     * so it is safe to call this function from several threads at the same time.
+     */
+    float nextCommunication(const InterSatelliteLink& edge, const float time_0,
+                            const OrientationState& orientation) const;
+
+    /** Returns the time when the edge is visible for next time beginning at time t0 (see VisibilityIndex).
      * @param time_0 [sec] start time
      * @return Absolute time in [sec] for next visibility. INFINITY if the edge will never be visible.
      */
-    float nextVisibility(const InterSatelliteLink& edge, const float t0);
+    float nextVisibility(const InterSatelliteLink& edge, const float t0) const {
+        return visibility->nextVisibility(islIndex(edge), t0);
+    }
+
+    /**
+     * @brief Forgets the orientations of all satellites (e.g. before a new solution is calculated).
+     */
+    void resetOrientations() { satellite_orientation.reset(instance.satelliteCount()); }
+
+    /**
+     * @brief Returns true, if solve() has to stop (see SolverOptions::cancel).
+     */
+    bool isCancelled() const { return options.cancel != nullptr && options.cancel->load(std::memory_order_relaxed); }
+
+  private:
+    std::shared_ptr<const PhysicalInstance> shared_instance; // must be initialized before the reference below
 
-    const PhysicalInstance instance;
+  protected:
+    const PhysicalInstance& instance;
+    const SolverOptions options;
     const float step_size = 1.0f; // [sec]
-    std::map<const Satellite*, TimelineEvent<glm::vec3>>
-        satellite_orientation; // Last known orientation for each satellite and the time when it changed.
+
+    OrientationState satellite_orientation;
+    SolverStats setup_stats; // recorded by the constructor, added to the stats of every solution
 
   private:
-    /** Calculates the time (beginning at time t0) when an edge is no longer interrupted by the central mass.
-     * This is done by iterating over t and check each time step if the edge is visible.
-     * @param time_0 [sec] start time
-     * @return Absolute time in [sec] for next visibility. INFINITY if the edge will never be visible.
+    /**
+     * @brief Returns the first time (beginning at time t0) that nextCommunication() checks: the next multiple of the
+     * step size or the beginning of the next visibility window.
      */
-    float findNextVisiblity(const InterSatelliteLink& edge, const float t0) const;
+    float nextCandidate(const size_t isl_idx, const float t0) const;
 
-    /** Calculates the time (beginning at time t0) when an edge is no longer visible.
-     * This is done by iterating over t and check each time step if the edge is visible.
-     * @param time_0 [sec] start time
-     * @return Absolute time in [sec] for end of visibility. INFINITY if the edge will never disappear.
+    /**
+     * @return Position of the given edge in the ISL vector of the instance.
      */
-    float findLastVisible(const InterSatelliteLink& edge, const float t0) const;
-
-    void createCache();
+    size_t islIndex(const InterSatelliteLink& edge) const;
 
-    std::map<const InterSatelliteLink*, Timeline<>> edge_time_slots;
-    std::map<const InterSatelliteLink*, float>
-        edge_cache_progress; // max. time for which cache (for visibility) is avaiable
+    std::shared_ptr<const VisibilityIndex> visibility; // shared by all solvers of the same instance
 };
 
 } // namespace dmsc
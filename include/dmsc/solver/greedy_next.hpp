@@ -9,8 +9,13 @@ namespace solver {
 
 class GreedyNext : public Solver {
   public:
-    GreedyNext(const PhysicalInstance& instance)
-        : Solver(instance) {}
+    GreedyNext(const PhysicalInstance& instance, const SolverOptions& options = SolverOptions())
+        : Solver(instance, options) {}
+    GreedyNext(std::shared_ptr<const PhysicalInstance> instance, const SolverOptions& options = SolverOptions())
+        : Solver(std::move(instance), options) {}
+    GreedyNext(std::shared_ptr<const PhysicalInstance> instance, std::shared_ptr<const VisibilityIndex> visibility,
+               const SolverOptions& options = SolverOptions())
+        : Solver(std::move(instance), std::move(visibility), options) {}
 
     DmscSolution solve();
 };
@@ -14,8 +14,17 @@ class GreedyNextKHop : public Solver {
      * @brief Construct a new GreedyNextKHop solver object.
      * @param k number of "extra" satellites - e.g. k=1 allows 3 edges (origin, hop, target)
      */
-    GreedyNextKHop(const PhysicalInstance& instance, const unsigned int k)
-        : Solver(instance)
+    GreedyNextKHop(const PhysicalInstance& instance, const unsigned int k,
+                   const SolverOptions& options = SolverOptions())
+        : Solver(instance, options)
+        , k(k) {}
+    GreedyNextKHop(std::shared_ptr<const PhysicalInstance> instance, const unsigned int k,
+                   const SolverOptions& options = SolverOptions())
+        : Solver(std::move(instance), options)
+        , k(k) {}
+    GreedyNextKHop(std::shared_ptr<const PhysicalInstance> instance, std::shared_ptr<const VisibilityIndex> visibility,
+                   const unsigned int k, const SolverOptions& options = SolverOptions())
+        : Solver(std::move(instance), std::move(visibility), options)
         , k(k) {}
 
     DmscSolution solve();
@@ -26,10 +35,35 @@ class GreedyNextKHop : public Solver {
     unsigned int k; // number of hops allowed
 
     /**
-     * @brief Breadth-first search
-     * @return first: boolean (if true, at least one path was found); second: adjacency matrix
+     * @brief Depth-first search for all simple paths from an origin to a destination with at most max_edges edges.
+     * Vertices are skipped, if the destination can't be reached with the remaining edges (distances to the
+     * destination are known from a breadth-first search).
+     */
+    struct PathSearch {
+        PathSearch(const AdjacencyList& adj, const uint32_t destination_idx, const uint32_t max_edges);
+
+        /**
+         * @brief Continues the current subpath with all neighbours of the given vertex (the last vertex of the
+         * subpath). The vertex must be marked as visited.
+         */
+        void run(const uint32_t vertex_idx);
+
+        const AdjacencyList& adj;
+        const uint32_t destination_idx;
+        const uint32_t max_edges;
+        std::vector<uint32_t> distance;                   // [edges] to the destination; > max_edges if out of reach
+        std::vector<bool> visited;                        // vertices of the current subpath
+        std::vector<bool> entry_used;                     // entries of the adjacency list which are part of a path
+        std::vector<const AdjacencyList::Entry*> subpath; // edges of the current subpath
+        std::vector<AdjacencyList::Entry> result;         // all edges of all paths found
+    };
+
+    /**
+     * @brief All simple paths with at most k + 3 edges (see PathSearch).
+     * @return first: boolean (if true, at least one path was found); second: all edges of these paths (as entries of
+     * the adjacency list, sorted by AdjacencyList::sortEntries)
      */
-    std::pair<bool, AdjacencyList> findPaths(const uint32_t from, const uint32_t to) const;
+    std::pair<bool, std::vector<AdjacencyList::Entry>> findPaths(const uint32_t from, const uint32_t to) const;
 };
 
 } // namespace solver
@@ -0,0 +1,36 @@
+#ifndef DMSC_GREEDY_NEXT_LAZY_H
+#define DMSC_GREEDY_NEXT_LAZY_H
+
+#include "../solver.hpp"
+#include "../solution_types.hpp"
+
+namespace dmsc {
+namespace solver {
+
+/**
+ * @brief Same schedule as GreedyNext, but the communication times are not recalculated for all remaining edges in each
+ * step. The times are kept in a priority queue and only recalculated if they might have changed:
+ * - one of the satellites of the edge changed its orientation (i.e. an incident edge was chosen)
+ * - no communication was possible within the search horizon of nextCommunication
+ */
+class GreedyNextLazy : public Solver {
+  public:
+    GreedyNextLazy(const PhysicalInstance& instance, const SolverOptions& options = SolverOptions())
+        : Solver(instance, options) {}
+    GreedyNextLazy(std::shared_ptr<const PhysicalInstance> instance, const SolverOptions& options = SolverOptions())
+        : Solver(std::move(instance), options) {}
+    GreedyNextLazy(std::shared_ptr<const PhysicalInstance> instance, std::shared_ptr<const VisibilityIndex> visibility,
+                   const SolverOptions& options = SolverOptions())
+        : Solver(std::move(instance), std::move(visibility), options) {}
+
+    DmscSolution solve();
+
+  private:
+    struct EdgeState; // last evaluation of an edge
+    struct QueueEntry;
+};
+
+} // namespace solver
+} // namespace dmsc
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef DMSC_PORTFOLIO_H
+#define DMSC_PORTFOLIO_H
+
+#include "../instance.hpp"
+#include "../solution_types.hpp"
+#include "../solver.hpp"
+#include "../visibility_index.hpp"
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dmsc {
+namespace solver {
+
+/**
+ * @brief Settings of Portfolio::solve().
+ */
+struct PortfolioOptions {
+    unsigned int worker_count = 0; // number of solvers that run at the same time (0: all hardware threads)
+
+    /**
+     * [sec] Wall-clock budget of the whole portfolio. When it is exceeded, running solvers are cancelled and solvers
+     * that did not start yet are skipped.
+     */
+    float time_budget = INFINITY;
+
+    /**
+     * [sec] The portfolio stops as soon as a solution with at most this scan time and full coverage (see
+     * Portfolio::Run::isFullCoverage) was found (e.g. a known lower bound).
+     */
+    float target_scan_time = -INFINITY;
+
+    /**
+     * Passed to every solver. The worker count applies to each solver, cancel is replaced by the flag of the portfolio
+     * and scan_cover_file is ignored (the best scan cover can be saved with ScanCover::save).
+     */
+    SolverOptions solver_options;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Runs several solvers for the same instance on a thread pool and keeps the solution with the best coverage
+ * and the smallest scan time. All solvers share one instance and one visibility index, so neither is copied or built
+ * again per solver.
+ */
+class Portfolio {
+  public:
+    /**
+     * @brief Creates and runs one solver with the shared instance, visibility index and options.
+     */
+    using Factory = std::function<DmscSolution(std::shared_ptr<const PhysicalInstance>,
+                                               std::shared_ptr<const VisibilityIndex>, const SolverOptions&)>;
+
+    enum class RunStatus {
+        COMPLETE,  // the solver scheduled all edges it could
+        CANCELLED, // stopped while running - its solution is ignored
+        SKIPPED,   // not started, because the portfolio was stopped before
+    };
+
+    /**
+     * @brief Outcome of one solver of the portfolio.
+     */
+    struct Run {
+        std::string name;
+        RunStatus status = RunStatus::SKIPPED;
+        float wall_time = 0.f;        // [sec] including the construction of the solver
+        float computation_time = 0.f; // [sec] as measured by the solver
+        float scan_time = INFINITY;   // [sec] makespan of the scan cover (see scanTime)
+        size_t scanned_edges = 0;
+
+        // coverage of a complete run
+        size_t served_communications = 0; // scheduled communications whose message reaches its target along the scans
+        size_t covered_isls = 0;          // different ISLs with at least one scan
+
+        /**
+         * @brief True, if the run served all scheduled communications and scanned every ISL of the instance.
+         */
+        bool isFullCoverage(const PhysicalInstance& instance) const {
+            return served_communications == instance.scheduled_communications.size() &&
+                   covered_isls == instance.islCount();
+        }
+
+        /**
+         * @brief Order of the complete runs: more served communications first, then more covered ISLs, then the
+         * smaller scan time. Solvers that drop communications (e.g. GreedyNextKHop without a path of k hops) can't win
+         * with a shorter scan cover.
+         */
+        bool isBetterThan(const Run& other) const {
+            if (served_communications != other.served_communications) {
+                return served_communications > other.served_communications;
+            }
+            if (covered_isls != other.covered_isls) {
+                return covered_isls > other.covered_isls;
+            }
+            return scan_time < other.scan_time;
+        }
+    };
+
+    struct Result {
+        static constexpr size_t NO_SOLUTION = ~size_t(0);
+
+        DmscSolution best;             // scan_time is set (the solvers leave it at 0), see Run::isBetterThan
+        size_t best_idx = NO_SOLUTION; // position of the best solver in runs
+        std::vector<Run> runs;         // in the order of the solvers
+        float wall_time = 0.f;         // [sec] of the whole portfolio
+    };
+
+    /**
+     * @brief Builds the visibility index for the given instance (see SolverOptions::worker_count and cache_file).
+     */
+    explicit Portfolio(std::shared_ptr<const PhysicalInstance> instance,
+                       const SolverOptions& options = SolverOptions());
+
+    /**
+     * @brief Uses an existing visibility index of the given instance (e.g. of another solver).
+     */
+    Portfolio(std::shared_ptr<const PhysicalInstance> instance, std::shared_ptr<const VisibilityIndex> visibility);
+
+    /**
+     * @brief Adds a solver with the given name (e.g. for the timings).
+     */
+    void add(const std::string& name, Factory factory) { solvers.push_back({name, std::move(factory)}); }
+
+    /**
+     * @brief Adds a solver of type S that is constructed with (instance, visibility, args..., options).
+     * E.g. add<GreedyNextKHop>("greedy_next_khop_2", 2u).
+     */
+    template <typename S, typename... Args>
+    void add(const std::string& name, const Args&... args) {
+        add(name, [args...](std::shared_ptr<const PhysicalInstance> instance,
+                            std::shared_ptr<const VisibilityIndex> visibility,
+                            const SolverOptions& options) {
+            return S(std::move(instance), std::move(visibility), args..., options).solve();
+        });
+    }
+
+    /**
+     * @brief Runs all solvers and returns the best complete solution (see Run::isBetterThan; ties: the solver that was
+     * added first).
+     */
+    Result solve(const PortfolioOptions& options = PortfolioOptions());
+
+    /**
+     * @brief Stops a running solve() as soon as possible. May be called from any thread. If no solve() is running, the
+     * next solve() skips all solvers.
+     */
+    void cancel() { cancelled.store(true); }
+
+    size_t solverCount() const { return solvers.size(); }
+    std::shared_ptr<const PhysicalInstance> getInstance() const { return instance; }
+    std::shared_ptr<const VisibilityIndex> getVisibilityIndex() const { return visibility; }
+
+  private:
+    struct Entry {
+        std::string name;
+        Factory factory;
+    };
+
+    std::shared_ptr<const PhysicalInstance> instance;
+    std::shared_ptr<const VisibilityIndex> visibility;
+    std::vector<Entry> solvers;
+    std::atomic<bool> cancelled{false}; // SolverOptions::cancel of all solvers
+};
+
+} // namespace solver
+} // namespace dmsc
+
+#endif
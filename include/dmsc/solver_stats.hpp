@@ -0,0 +1,72 @@
+#ifndef DMSC_SOLVER_STATS_H
+#define DMSC_SOLVER_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dmsc {
+
+/**
+ * @brief Events counted in the hot paths of the solvers.
+ */
+enum class StatCounter {
+    IS_BLOCKED,               // InterSatelliteLink::isBlocked() calls
+    KEPLER_ITERATIONS,        // iterations of the Kepler equation solver
+    CAN_ALIGN,                // InterSatelliteLink::canAlign() calls
+    NEXT_COMMUNICATION_STEPS, // candidate times checked by Solver::nextCommunication()
+    PATH_VERTICES,            // vertices visited by the path search of GreedyNextKHop
+    COUNT,
+};
+
+/**
+ * @brief Scopes whose time and number of calls are measured.
+ */
+enum class StatTimer {
+    VISIBILITY_INDEX,   // building the visibility index (without loading a cache file)
+    FIND_TIME_SLOTS,    // visibility windows of one ISL
+    NEXT_COMMUNICATION, // Solver::nextCommunication()
+    FIND_PATHS,         // paths of one scheduled communication (GreedyNextKHop)
+    SETUP,              // constructor of the solver (e.g. visibility index)
+    SOLVE,              // the whole solve()
+    COUNT,
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Counters and timers of a solution, summed over all threads. They are only collected if the library was built
+ * with the CMake option DMSC_ENABLE_STATS - otherwise all values are 0 and collected is false. The time of scopes that
+ * run on several threads at once is summed as well, so it can exceed the computation time.
+ */
+struct SolverStats {
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(StatCounter::COUNT);
+    static constexpr size_t TIMER_COUNT = static_cast<size_t>(StatTimer::COUNT);
+
+    bool collected = false;
+    uint64_t counters[COUNTER_COUNT] = {};
+    double timer_seconds[TIMER_COUNT] = {}; // [sec]
+    uint64_t timer_calls[TIMER_COUNT] = {};
+
+    uint64_t count(const StatCounter counter) const { return counters[static_cast<size_t>(counter)]; }
+    double seconds(const StatTimer timer) const { return timer_seconds[static_cast<size_t>(timer)]; }
+    uint64_t calls(const StatTimer timer) const { return timer_calls[static_cast<size_t>(timer)]; }
+
+    void add(const StatCounter counter, const uint64_t n) { counters[static_cast<size_t>(counter)] += n; }
+    void add(const StatTimer timer, const double seconds) {
+        timer_seconds[static_cast<size_t>(timer)] += seconds;
+        timer_calls[static_cast<size_t>(timer)]++;
+    }
+    SolverStats& operator+=(const SolverStats& other);
+
+    /**
+     * @brief Prints all counters and timers to stdout.
+     */
+    void print() const;
+
+    static const char* name(const StatCounter counter);
+    static const char* name(const StatTimer timer);
+};
+
+} // namespace dmsc
+
+#endif
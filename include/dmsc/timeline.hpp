@@ -2,8 +2,11 @@
 #define DMSC_TIMELINE_H
 
 #include "satellite.hpp"
+#include <algorithm>
 #include <map>
 #include <set>
+#include <type_traits>
+#include <vector>
 
 namespace dmsc {
 
@@ -52,11 +55,35 @@ struct TimelineEvent {
 
 // ------------------------------------------------------------------------------------------------
 
+/**
+ * @brief Containers a timeline can store its events in.
+ */
+enum class TimelineStorage {
+    ORDERED_SET,   // balanced tree; insertions anywhere in O(log n)
+    SORTED_VECTOR, // contiguous memory; appending events in chronological order is O(1) amortized, queries are faster
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Position of the last query in a timeline. Queries with (nearly) increasing times, e.g. during an animation,
+ * start their search there and are O(1) amortized. Only used by the SORTED_VECTOR storage.
+ */
+struct TimelineCursor {
+    size_t idx = 0;
+};
+
+// ------------------------------------------------------------------------------------------------
+
 /**
  * @brief Timeline containing TimelineEvents that do not overlap.
  */
-template <typename PayloadData = unsigned char>
+template <typename PayloadData = unsigned char, TimelineStorage Storage = TimelineStorage::ORDERED_SET>
 class Timeline {
+    using Event = TimelineEvent<PayloadData>;
+    using Container =
+        std::conditional_t<Storage == TimelineStorage::ORDERED_SET, std::set<Event>, std::vector<Event>>;
+
   public:
     /**
      * @brief Construct a new Timeline object
@@ -73,33 +100,72 @@ class Timeline {
      */
     size_t size() const { return events.size(); }
 
+    /**
+     * @brief Reserves memory for the given number of events (only with TimelineStorage::SORTED_VECTOR).
+     */
+    void reserve(const size_t n) {
+        if constexpr (Storage == TimelineStorage::SORTED_VECTOR) {
+            events.reserve(n);
+        }
+    }
+
+    /**
+     * @brief Iterators over all events in chronological order.
+     */
+    typename Container::const_iterator begin() const { return events.begin(); }
+    typename Container::const_iterator end() const { return events.end(); }
+
     /**
      * @brief Inserts a new event into this timeline.
      * The event must be valid and must not overlap with previously inserted events.
      *
      * @return true, if the event was inserted into this timeline
      */
-    bool insert(const TimelineEvent<PayloadData>& event) {
+    bool insert(const Event& event) {
         if (!event.isValid()) {
             return false;
         }
 
+        // fast path: the event starts after all other events ended
+        if constexpr (Storage == TimelineStorage::SORTED_VECTOR) {
+            if (events.empty() || events.back() < Event(event.t_begin, event.t_begin)) {
+                events.push_back(event);
+                return true;
+            }
+        }
+
         float t_next = nextTimeWithEvent(event.t_begin, false);
         // is there an event that overlaps with the new one?
         if (t_next != -1.f && t_next < event.t_end) {
             return false;
         }
 
-        return events.insert(event).second;
+        if constexpr (Storage == TimelineStorage::ORDERED_SET) {
+            return events.insert(event).second;
+        } else {
+            auto it = std::lower_bound(events.begin(), events.end(), event);
+            if (it != events.end() && !(event < *it)) { // same behaviour as the set: no equivalent events
+                return false;
+            }
+            events.insert(it, event);
+            return true;
+        }
     }
 
     /**
      * @brief Removes an event from this timeline.
      */
-    void remove(const TimelineEvent<PayloadData>& event) {
-        auto it = events.find(event);
-        if (it != events.end()) {
-            events.erase(it);
+    void remove(const Event& event) {
+        if constexpr (Storage == TimelineStorage::ORDERED_SET) {
+            auto it = events.find(event);
+            if (it != events.end()) {
+                events.erase(it);
+            }
+        } else {
+            auto it = std::lower_bound(events.begin(), events.end(), event);
+            if (it != events.end() && !(event < *it) && !(*it < event)) {
+                events.erase(it);
+            }
         }
     }
 
@@ -111,13 +177,12 @@ class Timeline {
      *
      * If no valid time is found, -1 is returned.
      */
-    float nextTimeWithEvent(const float t, const bool allow_loop = false) const {
+    float nextTimeWithEvent(const float t, const bool allow_loop = false, TimelineCursor* cursor = nullptr) const {
         if (events.size() == 0) {
             return -1.f;
         }
 
-        TimelineEvent<PayloadData> tmp(t, t);
-        auto e = events.lower_bound(tmp); // the first event that is NOT less than tmp (see "<" of TimelineEvent)
+        auto e = lowerBound(t, cursor); // the first event that is NOT less than tmp (see "<" of TimelineEvent)
         if (e != events.end()) {
             if (e->t_begin <= t) { // event is currently active
                 return t;
@@ -140,20 +205,19 @@ class Timeline {
      *
      * If no such event is found, an invalid event is returned.
      */
-    TimelineEvent<PayloadData> prevailingEvent(const float t, const bool allow_loop = false) const {
+    Event prevailingEvent(const float t, const bool allow_loop = false, TimelineCursor* cursor = nullptr) const {
         if (events.size() == 0) {
-            return TimelineEvent<PayloadData>(TIMELINE_ERR, -1.f);
+            return Event(TIMELINE_ERR, -1.f);
         }
 
-        TimelineEvent<PayloadData> tmp(t, t);
-        auto e = events.lower_bound(tmp); // the first element that is NOT less than tmp (see "<" of TimelineEvent)
+        auto e = lowerBound(t, cursor); // the first element that is NOT less than tmp (see "<" of TimelineEvent)
         if (e != events.end()) {
             return *e;
         } else if (allow_loop) { // no element found -> restart at the beginning?
             return *events.begin();
         }
 
-        return TimelineEvent<PayloadData>(TIMELINE_ERR, -1.f);
+        return Event(TIMELINE_ERR, -1.f);
     }
 
     /**
@@ -164,35 +228,65 @@ class Timeline {
      *
      * If no such event is found, an invalid event is returned.
      */
-    TimelineEvent<PayloadData> previousEvent(const float t, const bool allow_loop = false) const {
+    Event previousEvent(const float t, const bool allow_loop = false, TimelineCursor* cursor = nullptr) const {
         if (events.size() == 0) {
-            return TimelineEvent<PayloadData>(TIMELINE_ERR, -1.f);
+            return Event(TIMELINE_ERR, -1.f);
         }
 
-        TimelineEvent<PayloadData> tmp(t, t);
-        auto e = events.lower_bound(tmp); // the first element that is NOT less than tmp (see "<" of TimelineEvent)
+        auto e = lowerBound(t, cursor); // the first element that is NOT less than tmp (see "<" of TimelineEvent)
         if (e != events.begin()) {
             return *--e; // there is at least one element (see above) -> even if e is end(), we will get a valid event
         } else if (allow_loop) {
             return *--events.end();
         }
 
-        return TimelineEvent<PayloadData>(TIMELINE_ERR, -1.f);
+        return Event(TIMELINE_ERR, -1.f);
     }
 
     /**
      * @brief Returns the last event. If no events was insterted before, an invalid event is returned.
      */
-    TimelineEvent<PayloadData> lastEvent() const {
+    Event lastEvent() const {
         if (events.size() == 0) {
-            return TimelineEvent<PayloadData>(TIMELINE_ERR, -1.f);
+            return Event(TIMELINE_ERR, -1.f);
         }
 
         return *--events.end();
     }
 
   private:
-    std::set<TimelineEvent<PayloadData>> events;
+    Container events;
+
+    /**
+     * @brief Returns the first event that ends after t or is active at t (i.e. is not less than the event [t, t]).
+     * With a cursor, the search starts at the result of the previous query if t did not decrease.
+     */
+    typename Container::const_iterator lowerBound(const float t, TimelineCursor* cursor) const {
+        Event tmp(t, t);
+        if constexpr (Storage == TimelineStorage::ORDERED_SET) {
+            return events.lower_bound(tmp);
+        } else {
+            auto first = events.begin();
+            if (cursor != nullptr && cursor->idx <= events.size() &&
+                (cursor->idx == 0 || events[cursor->idx - 1] < tmp)) {
+                first += cursor->idx;
+
+                // monotonic queries usually move a few events at most
+                for (int i = 0; i < 4 && first != events.end() && *first < tmp; i++) {
+                    ++first;
+                }
+            }
+
+            if (first != events.end() && *first < tmp) {
+                first = std::lower_bound(first, events.end(), tmp);
+            }
+
+            if (cursor != nullptr) {
+                cursor->idx = static_cast<size_t>(first - events.begin());
+            }
+            return first;
+        }
+    }
 };
 
 } // namespace dmsc
@@ -0,0 +1,95 @@
+#ifndef DMSC_VISIBILITY_INDEX_H
+#define DMSC_VISIBILITY_INDEX_H
+
+#include "instance.hpp"
+#include "timeline.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dmsc {
+
+/**
+ * @brief Visibility windows of all ISLs of an instance within one period (the windows repeat afterwards). The index is
+ * built once and never changes afterwards, so all queries are const and one index can be shared by several solvers
+ * (e.g. as std::shared_ptr<const VisibilityIndex>) - even if they run on different threads.
+ */
+class VisibilityIndex {
+  public:
+    // visibility windows are appended in chronological order and never change afterwards
+    using TimeSlots = Timeline<unsigned char, TimelineStorage::SORTED_VECTOR>;
+
+    /**
+     * @brief Calculates the visibility windows of all ISLs of the given instance.
+     *
+     * @param worker_count number of threads used to calculate the windows (0: all hardware threads)
+     * @param cache_file If set, the windows are loaded from this file instead of being calculated. If the file does not
+     * exist or was created for a different instance, the windows are calculated and the file is (over)written.
+     * @param step_size [sec] Minimal step size of the root finding. Windows shorter than this might be missed.
+     */
+    VisibilityIndex(const PhysicalInstance& instance, const unsigned int worker_count = 1,
+                    const std::string& cache_file = "", const float step_size = 1.0f);
+
+    /** Returns the time when the edge is visible for next time beginning at time t0.
+     * @param t0 [sec] start time
+     * @return Absolute time in [sec] for next visibility. INFINITY if the edge will never be visible.
+     */
+    float nextVisibility(const size_t isl_idx, const float t0) const;
+
+    /**
+     * @brief Returns true, if the given time is part of a visibility window.
+     */
+    bool isVisible(const size_t isl_idx, const float t) const;
+
+    /**
+     * @brief Returns the beginning of the first visibility window that begins at or after the given time. The same
+     * window always results in the same value, regardless of t0.
+     * @return Absolute time in [sec]. INFINITY if the edge will never be visible.
+     */
+    float nextWindowBegin(const size_t isl_idx, const float t0) const;
+
+    /**
+     * @brief Returns true, if the index was built for the given instance and step size (see key).
+     */
+    bool matches(const PhysicalInstance& instance, const float step_size) const {
+        return key == cacheKey(instance, step_size) && time_slots.size() == instance.islCount();
+    }
+
+    // GETTER
+    const TimeSlots& getTimeSlots(const size_t isl_idx) const { return time_slots[isl_idx]; }
+    size_t islCount() const { return time_slots.size(); }
+    float getStepSize() const { return step_size; }
+
+  private:
+    /**
+     * @brief Calculates all visibility windows of the given edge within one period. Only reads shared data, so it is
+     * safe to call this function for different edges at the same time.
+     */
+    TimeSlots findTimeSlots(const InterSatelliteLink& edge) const;
+
+    /**
+     * @brief Hash of everything the visibility windows depend on: central mass, satellites, ISLs and step size.
+     */
+    static uint64_t cacheKey(const PhysicalInstance& instance, const float step_size);
+
+    /**
+     * @brief Loads the visibility windows from the given file. The file is memory-mapped and the windows are copied
+     * into the timelines (they are appended, because the file stores them sorted).
+     * @return true, if the file exists, is valid and belongs to this instance (see cacheKey).
+     */
+    bool loadCache(const std::string& file);
+
+    /**
+     * @brief Stores the visibility windows in a binary file.
+     */
+    void saveCache(const std::string& file) const;
+
+    float step_size;                   // [sec]
+    uint64_t key;                      // see cacheKey()
+    std::vector<float> periods;        // [sec] period of an ISL (same index as in the instance)
+    std::vector<TimeSlots> time_slots; // visibility windows of an ISL (same index as in the instance)
+};
+
+} // namespace dmsc
+
+#endif
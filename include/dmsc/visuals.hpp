@@ -1,7 +1,12 @@
+#ifndef DMSC_VISUALS_H
+#define DMSC_VISUALS_H
+
 #include "animation.hpp"
 #include "instance.hpp"
 #include "solution_types.hpp"
 #include "solver.hpp"
+#include <memory>
+#include <string>
 
 namespace dmsc {
 
@@ -14,4 +19,43 @@ void visualizeCustom(const PhysicalInstance& instance, const Animation& animatio
 void visualizeFreezeTagSolution(const PhysicalInstance& instance, const FreezeTagSolution& solution,
                                 const float t0 = 0.f);
 
+// Overloads for instances that are already shared (e.g. with a solver). The widget keeps a reference instead of a copy.
+void visualizeInstance(std::shared_ptr<const PhysicalInstance> instance, const float t0 = 0.f);
+void visualizeDmscSolution(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                           const float t0 = 0.f);
+void visualizeCustom(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation,
+                     const float t0 = 0.f);
+void visualizeFreezeTagSolution(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                                const float t0 = 0.f);
+
+/**
+ * @brief Settings of an offscreen rendering. The simulation time advances by a fixed step per frame, so the frames
+ * only depend on the settings - not on the speed of the machine.
+ */
+struct RenderOptions {
+    int width = 1280;               // [px]
+    int height = 720;               // [px]
+    float t0 = 0.f;                 // [sec] simulation time of the first frame
+    float dt = 10.f;                // [sec] simulation time between two frames
+    unsigned int frame_count = 300; // number of rendered frames
+    float zoom = 1.f;
+
+    // printf pattern of the PPM files with the frame number as its only argument (exactly one %d, %i or %u conversion,
+    // "%%" for a literal '%'). If it begins with '|', the rest is run as a command and the raw RGB frames are written
+    // to its standard input, e.g.
+    // "|ffmpeg -y -f rawvideo -pix_fmt rgb24 -s 1280x720 -r 30 -i - solution.mp4"
+    std::string output = "frame_%05d.ppm";
+};
+
+// Render the animation into files or an encoder without a window and without the GUI (see RenderOptions).
+void renderInstance(std::shared_ptr<const PhysicalInstance> instance, const RenderOptions& options);
+void renderDmscSolution(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                        const RenderOptions& options);
+void renderCustom(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation,
+                  const RenderOptions& options);
+void renderFreezeTagSolution(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                             const RenderOptions& options);
+
 } // namespace dmsc
+
+#endif
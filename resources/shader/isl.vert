@@ -0,0 +1,44 @@
+#version 420
+layout (location = 0) in uvec2 satellites; // (this end of the line, other end)
+layout (location = 1) in vec4 v_color;     // a >= 0: color of the ISL, a < 0: line of sight, a < -1: hidden
+
+layout (std140) uniform Global{	
+    mat4 camera_rotation; 
+    mat4 view; 
+    mat4 projection; 
+    mat4 scaling;
+    mat4 sun_angle;
+};
+
+uniform float sim_time;            // [sec]
+uniform float world_scale;         // [km] per unit
+uniform float radius_central_mass; // [km]
+
+out vec4 f_color;
+
+vec3 orbitPosition(int satellite, float time); // orbit.glsl
+
+void main(void) {
+    vec3 sat1 = orbitPosition(int(satellites.x), sim_time);
+    vec3 sat2 = orbitPosition(int(satellites.y), sim_time);
+
+    // closest point to the center of the central mass on the line (see InterSatelliteLink::clearance)
+    vec3 direction = sat2 - sat1;
+    float length_sq = dot(direction, direction);
+    float s = length_sq > 0.0 ? clamp(-dot(sat1, direction) / length_sq, 0.0, 1.0) : 0.0;
+    bool blocked = length(sat1 + s * direction) <= radius_central_mass;
+
+    if (v_color.a >= 0.0) {
+        f_color = v_color;
+    } else {
+        f_color = blocked ? vec4(1.0, 0.0, 0.0, 1.0) : vec4(0.0, 1.0, 0.0, 1.0);
+    }
+
+    // a hidden ISL collapses both vertices to the same satellite
+    if (v_color.a < -1.5 && satellites.y < satellites.x) {
+        sat1 = sat2;
+    }
+
+    vec4 camera_coords = camera_rotation * vec4(sat1 / world_scale, 1);
+	gl_Position = projection * view * scaling * camera_coords;
+}
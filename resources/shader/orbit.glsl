@@ -0,0 +1,29 @@
+// Positions of satellites calculated from their orbital elements (see ConstellationPropagator::packElements).
+// Appended to the shaders that declare orbitPosition(), so it contains no version directive.
+uniform samplerBuffer orbit_elements; // three texels per satellite
+
+const int KEPLER_ITERATIONS = 4;
+
+vec3 orbitPosition(int satellite, float time) {
+    vec4 e0 = texelFetch(orbit_elements, 3 * satellite);     // (semi-major axis, semi-minor axis, e, mean speed)
+    vec4 e1 = texelFetch(orbit_elements, 3 * satellite + 1); // (p, anomaly at time 0)
+    vec4 e2 = texelFetch(orbit_elements, 3 * satellite + 2); // (q, 0)
+    float e = e0.z;
+
+    // mean anomaly in [-pi, pi] and Danby's starting value (see kepler.cpp)
+    float m = e1.w + e0.w * time;
+    float k = round(m * 0.15915494);
+    m = (m - k * 6.28125) - k * 1.9353072e-3; // 2 * pi is split into two parts to keep m exact
+    float x = m + 0.85 * e * sign(m);
+
+    // Halley steps - circular orbits (e = 0) are already solved
+    for (int i = 0; i < KEPLER_ITERATIONS; i++) {
+        float sin_x = sin(x), cos_x = cos(x);
+        float f = x - e * sin_x - m;
+        float df = 1.0 - e * cos_x;
+        x -= 2.0 * f * df / (2.0 * df * df - f * e * sin_x);
+    }
+
+    // position in the orbital plane: r * cos(true_anomaly) = a * (cos(E) - e), r * sin(true_anomaly) = b * sin(E)
+    return e0.x * (cos(x) - e) * e1.xyz + e0.y * sin(x) * e2.xyz;
+}
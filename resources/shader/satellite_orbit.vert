@@ -0,0 +1,41 @@
+#version 420
+layout (location = 0) in vec3 coord3d;
+layout (location = 1) in vec4 v_color;
+layout (location = 2) in vec2 texcoord;
+layout (location = 3) in vec3 normal;
+layout (location = 8) in vec3 dyn_color; // r >= 0: color of the satellite, r < -1: hidden
+
+layout (std140) uniform Global{	
+    mat4 camera_rotation; 
+    mat4 view; 
+    mat4 projection; 
+    mat4 scaling;
+    mat4 sun_angle;
+};
+
+uniform float sim_time;    // [sec]
+uniform float world_scale; // [km] per unit
+
+out vec4 f_color;
+out vec4 f_normal;
+out vec3 f_coord3d;
+out vec2 f_texcoord;
+
+vec3 orbitPosition(int satellite, float time); // orbit.glsl
+
+void main(void) {
+    // one instance per satellite, the size of a satellite does not depend on the zoom
+    vec3 position = orbitPosition(gl_InstanceID, sim_time) / world_scale;
+    float size = dyn_color.r < -1.5 ? 0.0 : 1.0 / scaling[0][0];
+    vec4 camera_coords = vec4(position + size * coord3d, 1.0);
+	gl_Position = projection * view * camera_rotation * scaling * camera_coords;
+
+    if(dyn_color.r >= 0){
+        f_color = vec4(dyn_color, 1);
+    }else{
+        f_color = v_color;
+    }
+	
+    f_normal = camera_rotation * vec4(normal, 0);
+	f_coord3d = camera_coords.xyz;
+}
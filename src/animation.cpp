@@ -1,4 +1,5 @@
 #include "dmsc/animation.hpp"
+#include <algorithm>
 
 namespace dmsc {
 
@@ -28,7 +29,8 @@ bool Animation::addOrientationAnimation(const size_t satellite_idx, const float
 
 // ------------------------------------------------------------------------------------------------
 
-std::pair<bool, AnimationDetails> Animation::getSatelliteAnimation(const size_t satellite_idx, const float t) const {
+std::pair<bool, AnimationDetails> Animation::getSatelliteAnimation(const size_t satellite_idx, const float t,
+                                                                   TimelineCursor* cursor) const {
     // 1. are there animations scheduled for the satellite at all?
     auto it = satellites.find(satellite_idx);
     if (it == satellites.end()) {
@@ -36,7 +38,7 @@ std::pair<bool, AnimationDetails> Animation::getSatelliteAnimation(const size_t
     }
 
     // 2. are there animation details active right now?
-    auto event = it->second.prevailingEvent(t);
+    auto event = it->second.prevailingEvent(t, false, cursor);
     if (event.isValid() && event.t_begin <= t) { // the prevailing event must not be active rn - we have to check!
         return {true, event.data};
     }
@@ -46,7 +48,8 @@ std::pair<bool, AnimationDetails> Animation::getSatelliteAnimation(const size_t
 
 // ------------------------------------------------------------------------------------------------
 
-std::pair<bool, AnimationDetails> Animation::getISLAnimation(const size_t isl_idx, const float t) const {
+std::pair<bool, AnimationDetails> Animation::getISLAnimation(const size_t isl_idx, const float t,
+                                                             TimelineCursor* cursor) const {
     // 1. are there animations scheduled for the isl at all?
     auto it = intersatellite_links.find(isl_idx);
     if (it == intersatellite_links.end()) {
@@ -54,7 +57,7 @@ std::pair<bool, AnimationDetails> Animation::getISLAnimation(const size_t isl_id
     }
 
     // 2. are there animation details active right now?
-    auto event = it->second.prevailingEvent(t);
+    auto event = it->second.prevailingEvent(t, false, cursor);
     if (event.isValid() && event.t_begin <= t) { // the prevailing event must not be active rn - we have to check!
         return {true, event.data};
     }
@@ -62,4 +65,90 @@ std::pair<bool, AnimationDetails> Animation::getISLAnimation(const size_t isl_id
     return {false, AnimationDetails()};
 }
 
+// ------------------------------------------------------------------------------------------------
+
+CompiledAnimation::CompiledAnimation(const Animation& animation, const size_t satellite_count, const size_t isl_count)
+    : satellite_count(satellite_count) {
+    for (const auto& it : animation.satellites) {
+        if (it.first < satellite_count) {
+            addChanges(it.second, static_cast<uint32_t>(it.first));
+        }
+    }
+    for (const auto& it : animation.intersatellite_links) {
+        if (it.first < isl_count) {
+            addChanges(it.second, static_cast<uint32_t>(satellite_count + it.first));
+        }
+    }
+
+    // the changes of one entity are already in chronological order and must keep it (e.g. events of length 0)
+    std::stable_sort(changes.begin(), changes.end());
+    state.assign(satellite_count + isl_count, -1);
+    for (Change& change : changes) {
+        change.before = state[change.entity];
+        state[change.entity] = change.after;
+    }
+    state.assign(satellite_count + isl_count, -1);
+    changed.assign(satellite_count + isl_count, 0);
+    applied = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void CompiledAnimation::addChanges(const Animation::AnimationTimeline& timeline, const uint32_t entity) {
+    // an event is active in [t_begin, t_end) - or only at t_begin, if both are equal (see getSatelliteAnimation)
+    float t_end = -1.f;
+    for (const auto& event : timeline) {
+        if (!event.isValid()) {
+            continue;
+        }
+        int32_t idx = static_cast<int32_t>(events.size());
+        events.push_back(event.data);
+
+        if (!changes.empty() && changes.back().entity == entity && t_end == event.t_begin) {
+            changes.back().after = idx; // the previous event ends when this one begins
+        } else {
+            changes.push_back({event.t_begin, entity, -1, idx, false});
+        }
+        changes.push_back({event.t_end, entity, -1, -1, event.t_begin == event.t_end});
+        t_end = event.t_end;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void CompiledAnimation::seek(const float t) {
+    for (uint32_t satellite : changed_satellites) {
+        changed[satellite] = 0;
+    }
+    for (uint32_t isl : changed_isls) {
+        changed[satellite_count + isl] = 0;
+    }
+    changed_satellites.clear();
+    changed_isls.clear();
+
+    // forward: apply all changes until t, backward: revert all changes after t
+    while (applied < changes.size() && changes[applied].appliesAt(t)) {
+        setState(changes[applied].entity, changes[applied].after);
+        applied++;
+    }
+    while (applied > 0 && !changes[applied - 1].appliesAt(t)) {
+        applied--;
+        setState(changes[applied].entity, changes[applied].before);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void CompiledAnimation::setState(const uint32_t entity, const int32_t event) {
+    state[entity] = event;
+    if (changed[entity] == 0) {
+        changed[entity] = 1;
+        if (entity < satellite_count) {
+            changed_satellites.push_back(entity);
+        } else {
+            changed_isls.push_back(static_cast<uint32_t>(entity - satellite_count));
+        }
+    }
+}
+
 } // namespace dmsc
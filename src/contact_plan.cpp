@@ -0,0 +1,157 @@
+#include "dmsc/contact_plan.hpp"
+#include "thread_pool.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace dmsc {
+
+ContactPlan::ContactPlan(const PhysicalInstance& instance, const VisibilityIndex& visibility, const float horizon,
+                         const unsigned int worker_count)
+    : horizon(horizon)
+    , graph(instance.getAdjacencyMatrix()) {
+    const std::vector<InterSatelliteLink>& edges = instance.getISLs();
+    if (!visibility.matches(instance, visibility.getStepSize())) {
+        printf("The visibility index was not built for this instance.\n");
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    // the ISLs are independent of each other and every task writes into its own vector
+    std::vector<std::vector<Contact>> isl_contacts(edges.size());
+    tools::ThreadPool pool(worker_count);
+    pool.parallelFor(edges.size(), [&](const size_t i, const unsigned int) {
+        const InterSatelliteLink& edge = edges[i];
+        const VisibilityIndex::TimeSlots& windows = visibility.getTimeSlots(i);
+        double period = edge.getPeriod();
+        std::vector<Contact>& result = isl_contacts[i];
+
+        for (size_t n = 0; windows.size() > 0; n++) {
+            if (n > 0 && !(period > 0. && std::isfinite(period))) {
+                break; // the windows don't repeat
+            }
+            double offset = n == 0 ? 0. : period * n; // [sec]
+            if (offset >= horizon) {
+                break;
+            }
+            for (const TimelineEvent<>& window : windows) {
+                float t_begin = static_cast<float>(window.t_begin + offset);
+                float t_end = std::min(static_cast<float>(window.t_end + offset), horizon);
+                if (t_begin >= horizon) {
+                    break;
+                }
+
+                // a window that lasts until the end of a period continues in the next one
+                if (!result.empty() && result.back().t_end >= t_begin) {
+                    result.back().t_end = std::max(result.back().t_end, t_end);
+                    continue;
+                }
+                result.push_back({t_begin, t_end, edge.getOrientation(t_begin)});
+            }
+        }
+    });
+
+    offsets.reserve(edges.size() + 1);
+    offsets.push_back(0u);
+    for (std::vector<Contact>& isl : isl_contacts) {
+        contacts.insert(contacts.end(), isl.begin(), isl.end());
+        offsets.push_back(static_cast<uint32_t>(contacts.size()));
+        std::vector<Contact>().swap(isl);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+const ContactPlan::Contact* ContactPlan::nextContact(const size_t isl_idx, const float t) const {
+    const Contact* last = contactsEnd(isl_idx);
+    const Contact* contact =
+        std::upper_bound(contactsBegin(isl_idx), last, t, [](const float t, const Contact& c) { return t < c.t_end; });
+    return contact == last ? nullptr : contact;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+ContactPlan::Arrivals ContactPlan::search(const uint32_t source_idx, const float t0, const uint32_t max_hops,
+                                          const uint32_t target_idx) const {
+    const size_t satellite_count = graph.rowCount();
+
+    /* With limited hops, the states of the search are (satellite, hops so far). A state is dominated by a state of the
+     * same satellite that was reached earlier with fewer hops. Routes never visit a satellite twice, so more hops than
+     * satellites are the same as no limit. */
+    Arrivals arrivals;
+    bool limited = max_hops != ALL_HOPS && max_hops + 1 < satellite_count;
+    arrivals.level_count = limited ? max_hops + 1 : 1;
+    const uint32_t level_count = arrivals.level_count;
+    arrivals.times.assign(satellite_count, INFINITY);
+    arrivals.levels.assign(satellite_count, 0u);
+    arrivals.via.assign(satellite_count * level_count, Hop());
+    if (source_idx >= satellite_count) {
+        return arrivals;
+    }
+
+    std::vector<float> state_times(satellite_count * level_count, INFINITY);
+    std::vector<uint32_t> settled_level(satellite_count, level_count); // fewest hops of a settled state
+    using QueueItem = std::pair<float, size_t>;                        // (time, state)
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    size_t source_state = static_cast<size_t>(source_idx) * level_count;
+    state_times[source_state] = t0;
+    queue.push({t0, source_state});
+
+    while (!queue.empty()) {
+        auto [t, state] = queue.top();
+        queue.pop();
+        uint32_t satellite = static_cast<uint32_t>(state / level_count);
+        uint32_t level = static_cast<uint32_t>(state % level_count);
+        if (t > state_times[state] || settled_level[satellite] <= level) {
+            continue; // outdated or dominated
+        }
+        settled_level[satellite] = level;
+        if (arrivals.times[satellite] == INFINITY) {
+            arrivals.times[satellite] = t;
+            arrivals.levels[satellite] = level;
+            if (satellite == target_idx) {
+                break;
+            }
+        }
+        if (limited && level + 1 == level_count) {
+            continue; // no hops left
+        }
+
+        uint32_t next_level = limited ? level + 1 : 0;
+        for (const AdjacencyList::Entry& entry : graph[satellite]) {
+            size_t next_state = static_cast<size_t>(entry.column) * level_count + next_level;
+            float t_next = nextUsable(entry.item.isl_idx, t);
+            if (t_next < state_times[next_state] && settled_level[entry.column] > next_level) {
+                state_times[next_state] = t_next;
+                arrivals.via[next_state] = {entry.item.isl_idx, satellite, t_next};
+                queue.push({t_next, next_state});
+            }
+        }
+    }
+
+    return arrivals;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+std::vector<ContactPlan::Hop> ContactPlan::Arrivals::route(const uint32_t satellite_idx) const {
+    std::vector<Hop> hops;
+    if (satellite_idx >= times.size() || !isReachable(satellite_idx)) {
+        return hops;
+    }
+
+    size_t state = static_cast<size_t>(satellite_idx) * level_count + levels[satellite_idx];
+    while (via[state].isl_idx != NO_ISL) {
+        const Hop& hop = via[state];
+        hops.push_back(hop);
+        size_t level = state % level_count;
+        state = static_cast<size_t>(hop.from) * level_count + (level_count > 1 ? level - 1 : 0);
+    }
+    std::reverse(hops.begin(), hops.end());
+    return hops;
+}
+
+} // namespace dmsc
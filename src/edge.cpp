@@ -1,7 +1,15 @@
 #include "dmsc/edge.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace dmsc {
 
+constexpr float VISIBILITY_TOLERANCE = 0.001f; // [sec] accuracy of the refined edges of visibility windows
+constexpr int MAX_BISECTION_STEPS = 64;
+
+// ------------------------------------------------------------------------------------------------
+
 InterSatelliteLink::InterSatelliteLink(const uint32_t& v1_idx, const uint32_t& v2_idx,
                                        const std::vector<Satellite>& satellites, const CentralMass cm)
     : v1_idx(v1_idx)
@@ -20,41 +28,106 @@ InterSatelliteLink::InterSatelliteLink(const uint32_t& v1_idx, const uint32_t& v
     if (v1->getSemiMajorAxis() != v2->getSemiMajorAxis()) {
         period = v1->getPeriod() * v2->getPeriod(); // [sec]
     }
+
+    // vis-viva equation at the perigee
+    auto perigee_speed = [&cm](const Satellite& s) {
+        return sqrtf(cm.gravitational_parameter * (1.f + s.getEccentricity()) /
+                     (s.getSemiMajorAxis() * (1.f - s.getEccentricity())));
+    };
+    max_speed = std::max(perigee_speed(*v1), perigee_speed(*v2)); // [km/sec]
 };
 
 // ------------------------------------------------------------------------------------------------
 
 bool InterSatelliteLink::isBlocked(const float time) const {
-    // represent edge as a unit vector with origin at one of the satellites
-    glm::vec3 sat1 = v1->cartesian_coordinates(time);
-    glm::vec3 sat2 = v2->cartesian_coordinates(time);
-    glm::vec3 direction = glm::normalize(sat2 - sat1);
+    DMSC_STATS_COUNT(IS_BLOCKED, 1);
+    return clearance(time) <= 0.f;
+}
 
-    // check for intersection with a sphere (earth)
-    glm::vec3 sphere_center = glm::vec3(0.f);
-    glm::vec3 origin = sat1 - sphere_center;
+// ------------------------------------------------------------------------------------------------
 
-    float a = glm::dot(direction, direction);
-    float b = 2.f * glm::dot(origin, direction);
-    float c = glm::dot(origin, origin) - cm.radius_central_mass * cm.radius_central_mass;
-    float discr = b * b - 4 * a * c;
+float InterSatelliteLink::clearance(const float time) const {
+    return clearance(v1->cartesian_coordinates(time), v2->cartesian_coordinates(time));
+}
 
-    if (discr < .0f) { // no intersection at all
-        return false;
-    } else { // intersection possible (in front of or behind the ray-origin)
-        float t = -b - sqrt(discr);
-        if (t > .0f)
-            return true;
+// ------------------------------------------------------------------------------------------------
+
+float InterSatelliteLink::clearance(const glm::vec3& sat1, const glm::vec3& sat2, const float radius_central_mass) {
+    glm::vec3 direction = sat2 - sat1;
+
+    // closest point to the center of the central mass on the line segment between both satellites
+    float length_sq = glm::dot(direction, direction);
+    float s = 0.f;
+    if (length_sq > 0.f) {
+        s = glm::clamp(-glm::dot(sat1, direction) / length_sq, 0.f, 1.f);
+    }
+
+    return glm::length(sat1 + s * direction) - radius_central_mass;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+float InterSatelliteLink::nextVisible(const float t0, const float t_max, const float min_step) const {
+    return findVisibilityState(t0, t_max, min_step, true).second;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+float InterSatelliteLink::lastVisible(const float t0, const float t_max, const float min_step) const {
+    return findVisibilityState(t0, t_max, min_step, false).first;
+}
+
+// ------------------------------------------------------------------------------------------------
 
-        t = -b + sqrt(discr);
-        return t > .0f;
+std::pair<float, float> InterSatelliteLink::findVisibilityState(const float t0, const float t_max,
+                                                                const float min_step, const bool visible) const {
+    auto has_state = [visible](const float c) { return (c > 0.f) == visible; };
+
+    float t = t0;
+    float c = clearance(t);
+    if (has_state(c)) {
+        return {t0, t0};
+    }
+
+    /* The clearance can not change faster than the satellites move. So there is no root within |c| / max_speed
+     * seconds and we can skip this time without missing a change of the visibility. */
+    while (t < t_max) {
+        float step = std::max(std::fabs(c) / max_speed, min_step);
+        float t_next = std::min(t + step, t_max);
+        if (t_next <= t) { // step size below float resolution
+            t_next = std::nextafter(t, INFINITY);
+        }
+
+        float c_next = clearance(t_next);
+        if (has_state(c_next)) {
+            // refine the edge of the visibility window: t has the old state, t_next the new one
+            for (int i = 0; i < MAX_BISECTION_STEPS && t_next - t > VISIBILITY_TOLERANCE; i++) {
+                float t_mid = t + (t_next - t) / 2.f;
+                if (t_mid <= t || t_mid >= t_next) {
+                    break;
+                }
+
+                if (has_state(clearance(t_mid))) {
+                    t_next = t_mid;
+                } else {
+                    t = t_mid;
+                }
+            }
+            return {t, t_next};
+        }
+
+        t = t_next;
+        c = c_next;
     }
+
+    return {INFINITY, INFINITY};
 }
 
 // ------------------------------------------------------------------------------------------------
 
 bool InterSatelliteLink::canAlign(const TimelineEvent<glm::vec3>& sat1, const TimelineEvent<glm::vec3>& sat2,
                                   const float t) const {
+    DMSC_STATS_COUNT(CAN_ALIGN, 1);
     glm::vec3 target = getOrientation(t);
     float angle_sat1 = .0f;
     float angle_sat2 = .0f;
@@ -90,6 +163,34 @@ bool InterSatelliteLink::canAlign(const TimelineEvent<glm::vec3>& sat1, const Ti
 
 // ------------------------------------------------------------------------------------------------
 
+float InterSatelliteLink::earliestAlignment(const TimelineEvent<glm::vec3>& sat1,
+                                            const TimelineEvent<glm::vec3>& sat2, const float t) const {
+    glm::vec3 line_of_sight = v2->cartesian_coordinates(t) - v1->cartesian_coordinates(t);
+    float distance = glm::length(line_of_sight);
+    glm::vec3 target = line_of_sight / distance;
+
+    /* The distance changes by at most 2 * max_speed per second. Within max_skip it stays above half of the current
+     * distance, so the line of sight can't rotate faster than max_rate. The remaining turn time of a satellite then
+     * shrinks by at most (1 + max_rate / rotation_speed) per second. */
+    float max_skip = distance / (4.f * max_speed); // [sec]
+    float max_rate = 4.f * max_speed / distance;   // [rad/sec]
+
+    // time that is missing to turn a satellite, NaN is treated like an aligned satellite
+    auto skip = [&](const TimelineEvent<glm::vec3>& sat, const glm::vec3& direction, const float rotation_speed) {
+        if (!sat.isValid()) {
+            return 0.f;
+        }
+        float angle = std::acos(glm::dot(sat.data, direction)) - ALIGNMENT_TOLERANCE; // [rad]
+        float missing = angle / rotation_speed - (t - sat.t_begin);                 // [sec]
+        return missing > 0.f ? missing / (1.f + max_rate / rotation_speed) : 0.f;
+    };
+
+    float t_skip = std::max(skip(sat1, target, v1->getRotationSpeed()), skip(sat2, -target, v2->getRotationSpeed()));
+    return t + std::min(t_skip, max_skip);
+}
+
+// ------------------------------------------------------------------------------------------------
+
 glm::vec3 InterSatelliteLink::getOrientation(const float time) const {
     glm::vec3 sat1 = v1->cartesian_coordinates(time);
     glm::vec3 sat2 = v2->cartesian_coordinates(time);
@@ -0,0 +1,45 @@
+#ifndef DMSC_FAST_MATH_H
+#define DMSC_FAST_MATH_H
+
+#include <cmath>
+
+namespace dmsc {
+namespace tools {
+
+/**
+ * @brief Rounds to the nearest integer (|x| < 2^31). Unlike std::nearbyint, this is never a library call and can be
+ * vectorized.
+ */
+inline int roundToInt(const float x) { return static_cast<int>(x + (x >= 0.f ? 0.5f : -0.5f)); }
+
+/**
+ * @brief Sine and cosine for |x| < 1e5 without branches (absolute error < 1e-6), so loops calling it can be
+ * vectorized. The argument is reduced to [-pi/4, pi/4] and approximated by polynomials (coefficients from the cephes
+ * library).
+ */
+inline void fastSinCos(const float x, float& sin_x, float& cos_x) {
+    // x = j * pi/2 + r; pi/2 is split into three parts to keep r exact
+    int quadrant = roundToInt(x * 0.63661977236758134f);
+    float j = static_cast<float>(quadrant);
+    float r = x - j * 1.5703125f;
+    r -= j * 4.837512969970703125e-4f;
+    r -= j * 7.54978995489188216e-8f;
+    quadrant &= 3;
+
+    float r2 = r * r;
+    float s = ((-1.9515295891e-4f * r2 + 8.3321608736e-3f) * r2 - 1.6666654611e-1f) * r2 * r + r;
+    float c = ((2.443315711809948e-5f * r2 - 1.388731625493765e-3f) * r2 + 4.166664568298827e-2f) * r2 * r2 -
+              0.5f * r2 + 1.f;
+
+    // sin(r + j * pi/2) and cos(r + j * pi/2)
+    bool swap = (quadrant & 1) != 0;
+    float sin_r = swap ? c : s;
+    float cos_r = swap ? s : c;
+    sin_x = (quadrant & 2) != 0 ? -sin_r : sin_r;
+    cos_x = ((quadrant + 1) & 2) != 0 ? -cos_r : cos_r;
+}
+
+} // namespace tools
+} // namespace dmsc
+
+#endif
@@ -1,29 +1,163 @@
 #include "dmsc/instance.hpp"
+#include "dmsc/propagator.hpp"
+#include "dmsc/visibility_index.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <map>
 #include <random>
 #include <set>
-#include <sstream>
+#include <string_view>
 
 namespace dmsc {
 
+namespace {
+
+/**
+ * @brief Parses the fields (separated by ';') of a line in place. Blanks around a field are ignored.
+ */
+class FieldReader {
+  public:
+    FieldReader(const char* begin, const char* end)
+        : next(begin)
+        , end(end) {}
+
+    /**
+     * @brief Parses the next field.
+     * @return false, if there is no next field or it doesn't contain a valid value of the given type.
+     */
+    template <typename T>
+    bool read(T& value) {
+        skipBlanks();
+        std::from_chars_result result = std::from_chars(next, end, value);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+
+        next = result.ptr;
+        skipBlanks();
+        if (next != end) {
+            if (*next != ';') {
+                return false;
+            }
+            next++;
+        }
+        return true;
+    }
+
+  private:
+    void skipBlanks() {
+        while (next != end && (*next == ' ' || *next == '\t')) {
+            next++;
+        }
+    }
+
+    const char* next;
+    const char* end;
+};
+
+/** Binary instance format (native byte order):
+ *
+ * BinaryHeader
+ * SatelliteRecord satellites[satellite_count];
+ * EdgeRecord edges[edge_count];
+ */
+struct BinaryHeader {
+    char magic[8] = {'D', 'M', 'S', 'C', 'I', 'N', 'S', '\0'};
+    uint32_t version = 1u;
+    float radius_central_mass = 0.f;
+    float gravitational_parameter = 0.f;
+    uint32_t reserved = 0u;
+    uint64_t satellite_count = 0u;
+    uint64_t edge_count = 0u;
+};
+static_assert(sizeof(BinaryHeader) == 40, "The binary header must not contain padding bytes.");
+
+struct SatelliteRecord {
+    float height_perigee;
+    float eccentricity;
+    float inclination;
+    float argument_periapsis;
+    float raan;
+    float rotation_speed;
+    float initial_true_anomaly;
+    float cone_angle;
+};
+static_assert(sizeof(SatelliteRecord) == 32, "Satellite records must not contain padding bytes.");
+
+struct EdgeRecord {
+    uint32_t from_idx;
+    uint32_t to_idx;
+    uint32_t type; // see EdgeType
+};
+static_assert(sizeof(EdgeRecord) == 12, "Edge records must not contain padding bytes.");
+
+} // namespace
+
 // ========================
 // = Adjacency matrix
 // ========================
 
-AdjacencyList::AdjacencyList(const size_t size, const Item& default_value) {
-    matrix.reserve(size);
-    matrix.assign(size, std::map<uint32_t, Item>());
+AdjacencyList::AdjacencyList(const size_t row_count, std::vector<Entry> entries)
+    : entries(std::move(entries)) {
+    sortEntries(this->entries);
+
+    // count entries per row; row i then starts at the sum of all previous rows
+    offsets.assign(row_count + 1, 0u);
+    for (const Entry& e : this->entries) {
+        if (e.row >= row_count) {
+            printf("Row %u is not part of the adjacency list (%zu rows). \n", e.row, row_count);
+            assert(false);
+            exit(EXIT_FAILURE);
+        }
+        offsets[e.row + 1]++;
+    }
+    for (size_t i = 0; i < row_count; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+const AdjacencyList::Entry* AdjacencyList::Row::find(const uint32_t column) const {
+    const Entry* it =
+        std::lower_bound(first, last, column, [](const Entry& e, const uint32_t c) { return e.column < c; });
+    return (it != last && it->column == column) ? it : last;
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void AdjacencyList::clear() {
-    size_t size = matrix.capacity();
-    matrix.clear();
-    matrix.assign(size, std::map<uint32_t, Item>());
+    std::fill(offsets.begin(), offsets.end(), 0u);
+    entries.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void AdjacencyList::sortEntries(std::vector<Entry>& entries) {
+    std::stable_sort(entries.begin(), entries.end());
+
+    // keep the last of equal elements
+    auto same_element = [](const Entry& l, const Entry& r) { return l.row == r.row && l.column == r.column; };
+    std::reverse(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end(), same_element), entries.end());
+    std::reverse(entries.begin(), entries.end());
+}
+
+// ------------------------------------------------------------------------------------------------
+
+AdjacencyList::Row AdjacencyList::findRow(const std::vector<Entry>& sorted_entries, const uint32_t row) {
+    auto range = std::equal_range(sorted_entries.begin(),
+                                  sorted_entries.end(),
+                                  Entry(row, 0u, Item()),
+                                  [](const Entry& l, const Entry& r) { return l.row < r.row; });
+    const Entry* data = sorted_entries.data();
+    return Row(data + (range.first - sorted_entries.begin()), data + (range.second - sorted_entries.begin()));
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -33,75 +167,215 @@ void AdjacencyList::clear() {
 // ========================
 
 Instance::Instance(const std::string& file) {
-    std::string line_cache = "";
-    int mode = READ_INIT;
-    std::ifstream is(file);
-    if (is.fail()) {
+    tools::MappedFile mapped_file;
+    if (!mapped_file.open(file)) {
         std::cout << "File could not be opened!" << std::endl;
         return;
     }
 
-    while (std::getline(is, line_cache)) {
-        if (line_cache == "===END===" && is.peek() != EOF) {
-            mode++;
+    BinaryHeader expected;
+    if (mapped_file.size() >= sizeof(expected.magic) &&
+        std::memcmp(mapped_file.data(), expected.magic, sizeof(expected.magic)) == 0) {
+        loadBinary(mapped_file.data(), mapped_file.size(), file);
+    } else {
+        loadText(mapped_file.data(), mapped_file.size(), file);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void Instance::loadText(const char* data, const size_t size, const std::string& file) {
+    const char* next_line = data;
+    const char* file_end = data + size;
+    size_t line_number = 0;
+    int mode = READ_INIT;
+    while (next_line < file_end) {
+        // find the end of the current line (without line break)
+        const char* line_begin = next_line;
+        const char* line_end = static_cast<const char*>(std::memchr(line_begin, '\n', file_end - line_begin));
+        line_end = line_end ? line_end : file_end;
+        next_line = line_end < file_end ? line_end + 1 : file_end;
+        line_number++;
+        if (line_end > line_begin && line_end[-1] == '\r') {
+            line_end--;
+        }
+
+        std::string_view line(line_begin, line_end - line_begin);
+        if (line == "===END===") {
+            if (next_line < file_end) { // the file may end with a block separator
+                mode++;
+            }
+            continue;
+        }
+        if (line.empty()) {
             continue;
         }
 
         // split line by delimiter
-        std::string value_cache = "";
-        std::stringstream ss(line_cache);
-
-        try {
-            switch (mode) {
-            case READ_INIT:
-                std::getline(ss, value_cache, ';');
-                cm.radius_central_mass = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                cm.gravitational_parameter = std::stof(value_cache);
-                break;
-            case READ_ORBIT: {
-                StateVector sv;
-                std::getline(ss, value_cache, ';');
-                sv.height_perigee = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                sv.eccentricity = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                sv.raan = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                sv.argument_periapsis = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                sv.inclination = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                sv.rotation_speed = std::stof(value_cache);
-                std::getline(ss, value_cache, ';');
-                sv.initial_true_anomaly = std::stof(value_cache);
+        FieldReader fields(line_begin, line_end);
+        bool valid = true;
+        switch (mode) {
+        case READ_INIT:
+            valid = fields.read(cm.radius_central_mass) && fields.read(cm.gravitational_parameter);
+            break;
+        case READ_ORBIT: {
+            StateVector sv;
+            valid = fields.read(sv.height_perigee) && fields.read(sv.eccentricity) && fields.read(sv.raan) &&
+                    fields.read(sv.argument_periapsis) && fields.read(sv.inclination) &&
+                    fields.read(sv.rotation_speed) && fields.read(sv.initial_true_anomaly);
+            if (valid) {
                 satellites.push_back(sv);
-                break;
-            }
-            case READ_EDGE: {
-                std::getline(ss, value_cache, ';');
-                uint32_t from_idx = std::stoi(value_cache);
-                std::getline(ss, value_cache, ';');
-                uint32_t to_idx = std::stoi(value_cache);
-                std::getline(ss, value_cache, ';');
-                int type = std::stoi(value_cache);
-                Edge e = Edge(from_idx, to_idx, static_cast<EdgeType>(type));
-                edges.push_back(e);
-                break;
             }
-            default:
-                break;
+            break;
+        }
+        case READ_EDGE: {
+            uint32_t from_idx = 0u;
+            uint32_t to_idx = 0u;
+            int type = 0;
+            valid = fields.read(from_idx) && fields.read(to_idx) && fields.read(type);
+            if (valid) {
+                edges.push_back(Edge(from_idx, to_idx, static_cast<EdgeType>(type)));
             }
-        } catch (const std::exception&) {
-            std::cout << "Error while loading instance!" << std::endl;
+            break;
+        }
+        default:
+            break;
         }
+
+        if (!valid) {
+            printf("Error while loading instance %s: line %zu is invalid and was skipped.\n", file.c_str(),
+                   line_number);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool Instance::loadBinary(const char* data, const size_t size, const std::string& file) {
+    BinaryHeader header;
+    BinaryHeader expected;
+    if (size < sizeof(BinaryHeader)) {
+        printf("The binary instance %s is incomplete.\n", file.c_str());
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(BinaryHeader));
+    if (header.version != expected.version) {
+        printf("The binary instance %s has the unknown version %u.\n", file.c_str(), header.version);
+        return false;
+    }
+
+    // compare the counts before multiplying them, so a corrupt header can not wrap around
+    size_t remaining = size - sizeof(BinaryHeader); // [byte]
+    if (header.satellite_count > remaining / sizeof(SatelliteRecord)) {
+        printf("The binary instance %s is incomplete.\n", file.c_str());
+        return false;
+    }
+    size_t satellites_size = sizeof(SatelliteRecord) * header.satellite_count;
+    remaining -= satellites_size;
+    if (header.edge_count > remaining / sizeof(EdgeRecord)) {
+        printf("The binary instance %s is incomplete.\n", file.c_str());
+        return false;
+    }
+    size_t edges_size = sizeof(EdgeRecord) * header.edge_count;
+    if (remaining != edges_size) {
+        printf("The binary instance %s is incomplete.\n", file.c_str());
+        return false;
+    }
+
+    cm.radius_central_mass = header.radius_central_mass;
+    cm.gravitational_parameter = header.gravitational_parameter;
+
+    const char* satellite_data = data + sizeof(BinaryHeader);
+    satellites.resize(header.satellite_count);
+    for (size_t i = 0; i < satellites.size(); i++) {
+        SatelliteRecord record;
+        std::memcpy(&record, satellite_data + i * sizeof(SatelliteRecord), sizeof(SatelliteRecord));
+        StateVector& sv = satellites[i];
+        sv.height_perigee = record.height_perigee;
+        sv.eccentricity = record.eccentricity;
+        sv.inclination = record.inclination;
+        sv.argument_periapsis = record.argument_periapsis;
+        sv.raan = record.raan;
+        sv.rotation_speed = record.rotation_speed;
+        sv.initial_true_anomaly = record.initial_true_anomaly;
+        sv.cone_angle = record.cone_angle;
+    }
+
+    const char* edge_data = satellite_data + satellites_size;
+    edges.reserve(header.edge_count);
+    for (size_t i = 0; i < header.edge_count; i++) {
+        EdgeRecord record;
+        std::memcpy(&record, edge_data + i * sizeof(EdgeRecord), sizeof(EdgeRecord));
+        edges.push_back(Edge(record.from_idx, record.to_idx, static_cast<EdgeType>(record.type)));
+    }
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void Instance::save(const std::string& file, const InstanceFormat format) const {
+    switch (format) {
+    case InstanceFormat::TEXT:
+        saveText(file);
+        break;
+    case InstanceFormat::BINARY:
+        saveBinary(file);
+        break;
+    default:
+        break;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void Instance::saveBinary(const std::string& file) const {
+    std::ofstream fs(file, std::ios::binary | std::ios::trunc);
+    if (fs.fail()) {
+        printf("File %s could not be created. \n", file.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    BinaryHeader header;
+    header.radius_central_mass = cm.radius_central_mass;
+    header.gravitational_parameter = cm.gravitational_parameter;
+    header.satellite_count = satellites.size();
+    header.edge_count = edges.size();
+
+    std::vector<SatelliteRecord> satellite_records;
+    satellite_records.reserve(satellites.size());
+    for (const StateVector& sv : satellites) {
+        satellite_records.push_back({sv.height_perigee,
+                                     sv.eccentricity,
+                                     sv.inclination,
+                                     sv.argument_periapsis,
+                                     sv.raan,
+                                     sv.rotation_speed,
+                                     sv.initial_true_anomaly,
+                                     sv.cone_angle});
+    }
+
+    std::vector<EdgeRecord> edge_records;
+    edge_records.reserve(edges.size());
+    for (const Edge& e : edges) {
+        edge_records.push_back({e.from_idx, e.to_idx, static_cast<uint32_t>(e.type)});
+    }
+
+    fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fs.write(reinterpret_cast<const char*>(satellite_records.data()), sizeof(SatelliteRecord) * satellites.size());
+    fs.write(reinterpret_cast<const char*>(edge_records.data()), sizeof(EdgeRecord) * edges.size());
+    fs.close();
+    if (fs.fail()) {
+        printf("File %s could not be written. \n", file.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
     }
-    is.close();
 }
 
 // ------------------------------------------------------------------------------------------------
 
-void Instance::save(const std::string& file) const {
+void Instance::saveText(const std::string& file) const {
     std::ofstream fs(file);
     if (fs.fail()) {
         printf("File %s could not be created. \n", file.c_str());
@@ -204,14 +478,15 @@ PhysicalInstance::PhysicalInstance(const Instance& raw_instance) {
 // ------------------------------------------------------------------------------------------------
 
 void PhysicalInstance::buildAdjacencyMatrix() {
-    adjacency_list = AdjacencyList(satellites.size(), AdjacencyList::Item(0u, ~0u));
-
-    // fill list
+    std::vector<AdjacencyList::Entry> entries;
+    entries.reserve(2 * intersatellite_links.size());
     for (uint32_t isl_idx = 0; isl_idx < intersatellite_links.size(); isl_idx++) {
         const InterSatelliteLink& isl = intersatellite_links[isl_idx];
-        adjacency_list[isl.getV1Idx()][isl.getV2Idx()] = AdjacencyList::Item(1u, isl_idx);
-        adjacency_list[isl.getV2Idx()][isl.getV1Idx()] = AdjacencyList::Item(1u, isl_idx);
+        entries.push_back(AdjacencyList::Entry(isl.getV1Idx(), isl.getV2Idx(), AdjacencyList::Item(1u, isl_idx)));
+        entries.push_back(AdjacencyList::Entry(isl.getV2Idx(), isl.getV1Idx(), AdjacencyList::Item(1u, isl_idx)));
     }
+
+    adjacency_list = AdjacencyList(satellites.size(), std::move(entries));
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -240,23 +515,122 @@ PhysicalInstance& PhysicalInstance::operator=(const PhysicalInstance& source) {
 
 // ------------------------------------------------------------------------------------------------
 
-void PhysicalInstance::removeInvalidISL() {
-    for (int i = (int)intersatellite_links.size() - 1; i >= 0; i--) {
+std::vector<uint32_t> PhysicalInstance::removeInvalidISL(const unsigned int worker_count) {
+    std::vector<unsigned char> visible(intersatellite_links.size(), 0u);
+    tools::ThreadPool pool(worker_count);
+    pool.parallelFor(intersatellite_links.size(), [&](const size_t i, const unsigned int) {
         const InterSatelliteLink& e = intersatellite_links[i];
-        bool get_visible = false;
-        for (float t = 0.0f; t < e.getPeriod(); t += 1.0f) {
-            if (!e.isBlocked(t)) {
-                get_visible = true;
-                break;
+        visible[i] = e.nextVisible(0.f, e.getPeriod()) < INFINITY;
+    });
+    return removeISLs(visible);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+std::vector<uint32_t> PhysicalInstance::removeInvalidISL(const VisibilityIndex& visibility) {
+    if (visibility.islCount() != intersatellite_links.size()) {
+        printf("The visibility index does not belong to this instance (%zu ISLs instead of %zu).\n",
+               visibility.islCount(), intersatellite_links.size());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<unsigned char> visible(intersatellite_links.size(), 0u);
+    for (size_t i = 0; i < intersatellite_links.size(); i++) {
+        visible[i] = visibility.getTimeSlots(i).size() > 0;
+    }
+    return removeISLs(visible);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+std::vector<uint32_t> PhysicalInstance::removeISLs(const std::vector<unsigned char>& keep) {
+    std::vector<uint32_t> new_idx(intersatellite_links.size(), ~0u);
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < intersatellite_links.size(); i++) {
+        if (keep[i]) {
+            intersatellite_links[kept] = intersatellite_links[i];
+            new_idx[i] = kept++;
+        }
+    }
+
+    intersatellite_links.erase(intersatellite_links.begin() + kept, intersatellite_links.end());
+    intersatellite_links.shrink_to_fit();
+    buildAdjacencyMatrix();
+    return new_idx;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void PhysicalInstance::addCandidateISLs(const float max_range, const size_t sample_count) {
+    if (max_range <= 0.f || sample_count == 0 || satellites.size() < 2) {
+        return;
+    }
+
+    float max_period = 0.f;
+    for (const Satellite& s : satellites) {
+        max_period = std::max(max_period, s.getPeriod());
+    }
+
+    // cells are clamped, so neighbouring satellites always end up in neighbouring cells
+    constexpr int cell_bias = 1 << 20;
+    auto cell_of = [max_range](const float x) {
+        float c = std::floor(x / max_range);
+        return static_cast<int>(std::max(std::min(c, cell_bias - 1.f), -cell_bias + 1.f));
+    };
+    auto cell_key = [](const int x, const int y, const int z) {
+        return (static_cast<uint64_t>(x + cell_bias) << 42) | (static_cast<uint64_t>(y + cell_bias) << 21) |
+               static_cast<uint64_t>(z + cell_bias);
+    };
+    auto pair_key = [](const uint32_t v1_idx, const uint32_t v2_idx) {
+        return (static_cast<uint64_t>(v1_idx) << 32) | v2_idx;
+    };
+
+    ConstellationPropagator propagator(satellites);
+    std::vector<glm::vec3> positions;
+    std::vector<std::pair<uint64_t, uint32_t>> cells(satellites.size()); // cell key; satellite index
+    std::vector<uint64_t> pairs;                                         // see pair_key; v1_idx < v2_idx
+    for (size_t sample = 0; sample < sample_count; sample++) {
+        propagator.propagate(max_period * sample / sample_count, positions);
+        for (uint32_t i = 0; i < satellites.size(); i++) {
+            const glm::vec3& p = positions[i];
+            cells[i] = {cell_key(cell_of(p.x), cell_of(p.y), cell_of(p.z)), i};
+        }
+        std::sort(cells.begin(), cells.end());
+
+        for (uint32_t i = 0; i < satellites.size(); i++) {
+            const glm::vec3& p = positions[i];
+            int x = cell_of(p.x);
+            int y = cell_of(p.y);
+            int z = cell_of(p.z);
+            for (int neighbour = 0; neighbour < 27; neighbour++) {
+                uint64_t key = cell_key(x + neighbour % 3 - 1, y + (neighbour / 3) % 3 - 1, z + neighbour / 9 - 1);
+                auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, 0u));
+                for (; it != cells.end() && it->first == key; it++) {
+                    uint32_t j = it->second;
+                    glm::vec3 direction = positions[j] - p;
+                    if (j <= i || glm::dot(direction, direction) > max_range * max_range) {
+                        continue;
+                    }
+                    if (InterSatelliteLink::clearance(p, positions[j], cm.radius_central_mass) > 0.f) {
+                        pairs.push_back(pair_key(i, j));
+                    }
+                }
             }
         }
 
-        // remove edge
-        if (!get_visible) {
-            intersatellite_links.erase(intersatellite_links.begin() + i);
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    }
+
+    for (uint64_t pair : pairs) {
+        uint32_t v1_idx = static_cast<uint32_t>(pair >> 32);
+        uint32_t v2_idx = static_cast<uint32_t>(pair);
+        AdjacencyList::Row row = adjacency_list[v1_idx];
+        if (row.find(v2_idx) == row.end()) {
+            intersatellite_links.push_back(InterSatelliteLink(v1_idx, v2_idx, satellites, cm));
         }
     }
-    intersatellite_links.shrink_to_fit();
     buildAdjacencyMatrix();
 }
 
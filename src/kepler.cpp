@@ -0,0 +1,67 @@
+#include "dmsc/kepler.hpp"
+#include "fast_math.hpp"
+#include "stats.hpp"
+
+namespace dmsc {
+
+namespace {
+
+/**
+ * @brief Reduces the mean anomaly to [-pi, pi] and returns a starting value for the eccentric anomaly.
+ * Starter by Danby: E = M + 0.85 * e * sign(sin(M))
+ */
+inline float keplerStart(const float mean_anomaly, const float e, float& m) {
+    // 2 * pi is split into two parts to keep m exact
+    float k = static_cast<float>(tools::roundToInt(mean_anomaly * 0.15915494309189534f));
+    m = (mean_anomaly - k * 6.28125f) - k * 1.9353071795864769e-3f;
+    return m + 0.85f * e * std::copysign(1.f, m);
+}
+
+/**
+ * @brief Halley step for the Kepler equation: f / (f' - f * f'' / (2 * f'))
+ */
+inline float keplerStep(const float x, const float e, const float m) {
+    float sin_x, cos_x;
+    tools::fastSinCos(x, sin_x, cos_x);
+    float f = x - e * sin_x - m;
+    float df = 1.f - e * cos_x;
+    return 2.f * f * df / (2.f * df * df - f * e * sin_x);
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+
+float eccentricAnomaly(const float mean_anomaly, const float eccentricity) {
+    float m;
+    float x = keplerStart(mean_anomaly, eccentricity, m);
+    for (int i = 0; i < KEPLER_ITERATIONS; i++) {
+        DMSC_STATS_COUNT(KEPLER_ITERATIONS, 1);
+        float step = keplerStep(x, eccentricity, m);
+        x -= step;
+
+        // cubic convergence: the remaining error is far below the tolerance
+        if (std::fabs(step) < 1e-4f) {
+            break;
+        }
+    }
+
+    return x;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void eccentricAnomaly(const size_t n, const float* mean_anomaly, const float* eccentricity, float* eccentric_anomaly) {
+    // always KEPLER_ITERATIONS steps, so the loop has no branches and can be vectorized
+    DMSC_STATS_COUNT(KEPLER_ITERATIONS, n * KEPLER_ITERATIONS);
+    for (size_t i = 0; i < n; i++) {
+        float m;
+        float x = keplerStart(mean_anomaly[i], eccentricity[i], m);
+        for (int it = 0; it < KEPLER_ITERATIONS; it++) {
+            x -= keplerStep(x, eccentricity[i], m);
+        }
+        eccentric_anomaly[i] = x;
+    }
+}
+
+} // namespace dmsc
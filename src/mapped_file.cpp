@@ -0,0 +1,80 @@
+#include "mapped_file.hpp"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DMSC_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dmsc {
+namespace tools {
+
+bool MappedFile::open(const std::string& file) {
+    close();
+
+#ifdef DMSC_USE_MMAP
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    if (length != 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        content = static_cast<const char*>(address);
+        is_mapped = true;
+    }
+    ::close(fd); // the mapping stays valid
+#else
+    std::ifstream is(file, std::ios::binary | std::ios::ate);
+    if (is.fail()) {
+        return false;
+    }
+
+    length = static_cast<size_t>(is.tellg());
+    buffer.resize(length);
+    is.seekg(0);
+    if (length != 0 && !is.read(buffer.data(), length)) {
+        buffer.clear();
+        length = 0;
+        return false;
+    }
+    content = buffer.data();
+#endif
+
+    is_open = true;
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void MappedFile::close() {
+#ifdef DMSC_USE_MMAP
+    if (is_mapped) {
+        munmap(const_cast<char*>(content), length);
+    }
+#endif
+    buffer.clear();
+    buffer.shrink_to_fit();
+    content = nullptr;
+    length = 0;
+    is_open = false;
+    is_mapped = false;
+}
+
+} // namespace tools
+} // namespace dmsc
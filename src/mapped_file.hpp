@@ -0,0 +1,43 @@
+#ifndef DMSC_MAPPED_FILE_H
+#define DMSC_MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+
+namespace dmsc {
+namespace tools {
+
+/**
+ * @brief Read-only view of a whole file. On POSIX systems the file is memory-mapped, otherwise it is read into memory
+ * at once.
+ */
+class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the given file. A previously opened file is closed.
+     * @return true, if the file could be opened.
+     */
+    bool open(const std::string& file);
+    void close();
+
+    const char* data() const { return content; }
+    size_t size() const { return length; }
+    bool isOpen() const { return is_open; }
+
+  private:
+    const char* content = nullptr;
+    size_t length = 0;
+    bool is_open = false;
+    bool is_mapped = false;
+    std::vector<char> buffer; // file content, if memory mapping is not available
+};
+
+} // namespace tools
+} // namespace dmsc
+
+#endif
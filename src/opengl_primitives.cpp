@@ -3,6 +3,33 @@
 namespace dmsc {
 namespace OpenGLPrimitives {
 
+namespace {
+
+/**
+ * @brief Writes the segments of a (dashed) line, color is already converted to the color type of Vertex.
+ */
+template <typename Vertex, typename Color>
+void writeSegments(Vertex* out, const glm::vec3& p1, const glm::vec3& p2, const Color& color, bool dashed) {
+    // for every colored segment we need a transparent counterpart - except the last segment
+    int colored_segments = static_cast<int>(lineVertexCount(dashed)) / 2;
+    int segments = 2 * colored_segments - 1;
+    glm::vec3 distance_vector = p2 - p1;
+
+    for (float i = 0; i < colored_segments; i++) {
+        Vertex v1;
+        v1.color = color;
+        v1.position = p1 + distance_vector * (i * 2 / segments);
+        *out++ = v1;
+
+        Vertex v2;
+        v2.color = color;
+        v2.position = p1 + distance_vector * ((i * 2 + 1) / segments);
+        *out++ = v2;
+    }
+}
+
+} // namespace
+
 /////////////////////////////////////
 /// Object
 /////////////////////////////////////
@@ -49,6 +76,132 @@ std::vector<GLubyte> Object::elements_8() const {
     return result;
 }
 
+/////////////////////////////////////
+// StreamStorage
+/////////////////////////////////////
+
+void StreamStorage::allocate(const GLenum target, const size_t region_size, tools::BufferStorageProc buffer_storage) {
+    release();
+    this->target = target;
+    this->region_size = region_size;
+    GLsizeiptr size = static_cast<GLsizeiptr>(REGIONS * region_size);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    if (buffer_storage != nullptr) {
+        // immutable storage that stays mapped - flushed explicitly, so it does not need to be coherent
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
+        buffer_storage(target, size, nullptr, flags);
+        persistent = static_cast<unsigned char*>(glMapBufferRange(target, 0, size, flags | GL_MAP_FLUSH_EXPLICIT_BIT));
+    } else {
+        glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(target, 0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void* StreamStorage::map(const unsigned int region) {
+    mapped_offset = (region % REGIONS) * region_size;
+    if (persistent != nullptr) {
+        return persistent + mapped_offset;
+    }
+
+    // the caller guarantees that the GPU does not use this region anymore
+    glBindBuffer(target, buffer);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                       GL_MAP_FLUSH_EXPLICIT_BIT;
+    return glMapBufferRange(target, mapped_offset, region_size, flags);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void StreamStorage::unmap(const size_t bytes_written) {
+    glBindBuffer(target, buffer);
+    if (persistent != nullptr) {
+        if (bytes_written > 0) {
+            glFlushMappedBufferRange(target, mapped_offset, bytes_written);
+        }
+    } else {
+        // the range is relative to the mapped region
+        if (bytes_written > 0) {
+            glFlushMappedBufferRange(target, 0, bytes_written);
+        }
+        glUnmapBuffer(target);
+    }
+    glBindBuffer(target, 0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void StreamStorage::release() {
+    if (buffer == 0u) {
+        return;
+    }
+
+    if (persistent != nullptr) {
+        glBindBuffer(target, buffer);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+        persistent = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0u;
+}
+
+/////////////////////////////////////
+// ViewCulling
+/////////////////////////////////////
+
+ViewCulling::ViewCulling(const glm::mat4& world_to_clip, const glm::vec3& eye, const float occluder_radius)
+    : eye(eye)
+    , occluder_radius(occluder_radius) {
+    // planes of the frustum: w +- x >= 0, w +- y >= 0, w +- z >= 0 (Gribb/Hartmann)
+    glm::mat4 m = glm::transpose(world_to_clip); // rows of world_to_clip
+    for (int i = 0; i < 3; i++) {
+        planes[2 * i] = m[3] + m[i];
+        planes[2 * i + 1] = m[3] - m[i];
+    }
+    for (glm::vec4& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+unsigned int ViewCulling::outcode(const glm::vec3& center, const float radius) const {
+    unsigned int code = 0u;
+    for (unsigned int i = 0; i < 6; i++) {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+            code |= 1u << i;
+        }
+    }
+    return code;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool ViewCulling::isOccluded(const glm::vec3& center, const float radius) const {
+    // closest point of the line of sight (eye -> center) to the origin
+    glm::vec3 sight = center - eye;
+    float t = glm::clamp(-glm::dot(eye, sight) / glm::dot(sight, sight), 0.f, 1.f);
+    glm::vec3 closest = eye + t * sight;
+    float r = occluder_radius - radius;
+    return r > 0.f && glm::dot(closest, closest) < r * r;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool ViewCulling::isCulled(const glm::vec3& p1, const glm::vec3& p2) const {
+    if ((outcode(p1) & outcode(p2)) != 0u) {
+        return true;
+    }
+
+    // the shadow can only be left across the visible side of the occluder and a line intersects a sphere only once,
+    // so a line with both ends in the shadow stays in it
+    return isOccluded(p1) && isOccluded(p2);
+}
+
 /////////////////////////////////////
 // Object meshes
 /////////////////////////////////////
@@ -142,13 +295,13 @@ Object createSatellite() {
     Object model = Object();
     model.gl_draw_mode = GL_TRIANGLES;
 
-    return createSphere(0.007f, glm::vec3(0.0f), 10);
+    return createSphere(SATELLITE_RADIUS, glm::vec3(0.0f), 10);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 Object createOrbit(const Satellite& orbit, const float scale, const glm::vec3 center) {
-    unsigned int number_of_sides = 130u;
+    unsigned int number_of_sides = ORBIT_VERTICES;
     Object model = Object();
     model.gl_draw_mode = GL_LINE_LOOP;
 
@@ -170,25 +323,21 @@ Object createOrbit(const Satellite& orbit, const float scale, const glm::vec3 ce
 Object createLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed) {
     Object m = Object();
     m.gl_draw_mode = GL_LINES;
+    m.vertices.resize(lineVertexCount(dashed));
+    writeLine(m.vertices.data(), p1, p2, color, dashed);
+    return m;
+}
 
-    // for every colored segment we need a transparent counterpart - except the last segment
-    int colored_segments = dashed ? 15 : 1;
-    int segments = 2 * colored_segments - 1;
-    glm::vec3 distance_vector = p2 - p1;
+// ------------------------------------------------------------------------------------------------
 
-    for (float i = 0; i < colored_segments; i++) {
-        VertexData v1;
-        v1.color = color;
-        v1.position = p1 + distance_vector * (i * 2 / segments);
-        m.vertices.push_back(v1);
+void writeLine(VertexData* out, const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed) {
+    writeSegments(out, p1, p2, color, dashed);
+}
 
-        VertexData v2;
-        v2.color = color;
-        v2.position = p1 + distance_vector * ((i * 2 + 1) / segments);
-        m.vertices.push_back(v2);
-    }
+// ------------------------------------------------------------------------------------------------
 
-    return m;
+void writeLine(LineVertex* out, const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed) {
+    writeSegments(out, p1, p2, packColor(color), dashed);
 }
 
 // ------------------------------------------------------------------------------------------------
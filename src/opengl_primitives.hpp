@@ -5,8 +5,13 @@
 
 #include "dmsc/glm_include.hpp"
 #include "dmsc/satellite.hpp"
+#include "opengl_toolkit.hpp"
+#include <algorithm>
+#include <cassert>
 #include <glad/glad.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string>
 #include <vector>
 
@@ -28,8 +33,154 @@ struct GLBuffer {
     void gen() { glGenBuffers(1, &buffer_idx); }
     void pushToGPU() const {
         glBindBuffer(GL_ARRAY_BUFFER, buffer_idx);
-        glBufferData(GL_ARRAY_BUFFER, byte_size(), &values[0], usage);
+        glBufferData(GL_ARRAY_BUFFER, byte_size(), values.data(), usage);
     }
+
+    /**
+     * @brief Overwrites the data on the GPU without reallocating it. The size must not change since pushToGPU().
+     */
+    void updateGPU() const {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_idx);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, byte_size(), values.data());
+    }
+
+    /**
+     * @brief Overwrites only the values [first, first + count) on the GPU.
+     */
+    void updateGPU(const size_t first, const size_t count) const {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_idx);
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(T) * first, sizeof(T) * count, values.data() + first);
+    }
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief GPU memory for data that is rewritten every frame. The memory is split into REGIONS equally sized regions:
+ * the CPU writes into one region while the GPU may still read the regions of the previous frames. The caller has to
+ * ensure (e.g. with a fence per region) that the GPU finished reading a region before it is mapped again.
+ *
+ * If glBufferStorage is available, the memory is mapped once and stays mapped. Otherwise every map() maps the
+ * region unsynchronized. In both cases only the written part of a region is flushed.
+ */
+class StreamStorage {
+  public:
+    static constexpr unsigned int REGIONS = 3; // triple buffering
+
+    StreamStorage() = default;
+    ~StreamStorage() { release(); }
+    StreamStorage(const StreamStorage&) = delete;
+    StreamStorage& operator=(const StreamStorage&) = delete;
+
+    /**
+     * @brief Creates a new buffer (the buffer id changes) with REGIONS * region_size bytes.
+     * @param buffer_storage nullptr: use mutable storage and map each region on its own
+     */
+    void allocate(const GLenum target, const size_t region_size, tools::BufferStorageProc buffer_storage);
+
+    /**
+     * @brief Returns a pointer to the given region. The memory is write only.
+     */
+    void* map(const unsigned int region);
+
+    /**
+     * @brief Makes the first bytes_written bytes of the mapped region visible to the GPU.
+     */
+    void unmap(const size_t bytes_written);
+
+    /**
+     * @brief Deletes the buffer (must be called while the GL context still exists).
+     */
+    void release();
+
+    GLuint id() const { return buffer; }
+    size_t regionSize() const { return region_size; }
+    bool isPersistent() const { return persistent != nullptr; }
+
+  private:
+
+    GLenum target = GL_ARRAY_BUFFER;
+    GLuint buffer = 0u;
+    size_t region_size = 0;              // [byte]
+    size_t mapped_offset = 0;            // [byte] beginning of the mapped region
+    unsigned char* persistent = nullptr; // the whole buffer, if it is mapped persistently
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Typed view of a StreamStorage. The elements of a frame are appended to the mapped region (like a vector) and
+ * can not be read back.
+ */
+template <typename T>
+class StreamBuffer {
+  public:
+    /**
+     * @param capacity Maximum number of elements per frame.
+     * @param alignment [byte] Required alignment of the regions (e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT).
+     */
+    void allocate(const GLenum target, const size_t capacity, tools::BufferStorageProc buffer_storage,
+                  const size_t alignment = sizeof(T)) {
+        // regions must begin at an element, so first() can be used as base vertex/instance
+        element_capacity = std::max(capacity, size_t(1));
+        while ((element_capacity * sizeof(T)) % alignment != 0) {
+            element_capacity++;
+        }
+        storage.allocate(target, element_capacity * sizeof(T), buffer_storage);
+    }
+
+    void map(const unsigned int region) {
+        data = static_cast<T*>(storage.map(region));
+        region_first = region * element_capacity;
+        count = 0;
+    }
+
+    void unmap() {
+        storage.unmap(count * sizeof(T));
+        data = nullptr;
+    }
+
+    /**
+     * @brief Appends n elements and returns a pointer to the first of them.
+     */
+    T* reserve(const size_t n) {
+        if (count + n > element_capacity) {
+            printf("Stream buffer overflow: %zu of %zu elements.\n", count + n, element_capacity);
+            assert(false);
+            exit(EXIT_FAILURE);
+        }
+        T* p = data + count;
+        count += n;
+        return p;
+    }
+
+    void push_back(const T& value) { *reserve(1) = value; }
+
+    /**
+     * @brief Appends copies of value until the buffer contains n elements.
+     */
+    void fill(const size_t n, const T& value) {
+        if (n > count) {
+            size_t missing = n - count;
+            std::fill_n(reserve(missing), missing, value);
+        }
+    }
+
+    void release() { storage.release(); }
+
+    size_t size() const { return count; }                     // elements in the current frame
+    size_t capacity() const { return element_capacity; }       // elements per frame
+    size_t first() const { return region_first; }              // index of the first element of the region
+    size_t offset() const { return region_first * sizeof(T); } // [byte]
+    GLuint id() const { return storage.id(); }
+    bool isPersistent() const { return storage.isPersistent(); }
+
+  private:
+    StreamStorage storage;
+    T* data = nullptr;
+    size_t element_capacity = 0;
+    size_t region_first = 0;
+    size_t count = 0;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -48,6 +199,27 @@ struct VertexData {
     VertexData(const glm::vec3& v) { position = v; }
 };
 
+/**
+ * @brief Compact vertex of the lines that are rebuilt every frame: position and an RGBA8 color (see packColor).
+ */
+struct LineVertex {
+    glm::vec3 position = glm::vec3(0.f);
+    GLuint color = 0u;
+};
+static_assert(sizeof(LineVertex) == 16, "LineVertex must not contain padding");
+
+/**
+ * @brief Packs a color with components in [0, 1] into RGBA8 (red in the lowest byte).
+ */
+inline GLuint packColor(const glm::vec4& color) {
+    GLuint packed = 0u;
+    for (int i = 3; i >= 0; i--) {
+        float c = std::min(std::max(color[i], 0.f), 1.f);
+        packed = (packed << 8) | static_cast<GLuint>(c * 255.f + .5f);
+    }
+    return packed;
+}
+
 // ------------------------------------------------------------------------------------------------
 
 /**
@@ -144,6 +316,50 @@ struct ObjectInfo {
 
 // ------------------------------------------------------------------------------------------------
 
+/**
+ * @brief Conservative visibility tests in world coordinates: against the view frustum and against a sphere at the
+ * origin (the central mass) that hides everything behind it. An object is only reported as culled if it is certainly
+ * invisible.
+ */
+class ViewCulling {
+  public:
+    ViewCulling() = default;
+
+    /**
+     * @param world_to_clip projection * view * model
+     * @param eye position of the camera
+     * @param occluder_radius radius of the sphere at the origin
+     */
+    ViewCulling(const glm::mat4& world_to_clip, const glm::vec3& eye, const float occluder_radius);
+
+    /**
+     * @brief Bit i is set, if the sphere is completely outside of frustum plane i.
+     */
+    unsigned int outcode(const glm::vec3& center, const float radius = 0.f) const;
+
+    /**
+     * @brief Returns true, if the sphere is hidden behind the occluder (or inside of it).
+     */
+    bool isOccluded(const glm::vec3& center, const float radius = 0.f) const;
+
+    bool isCulled(const glm::vec3& center, const float radius) const {
+        return outcode(center, radius) != 0u || isOccluded(center, radius);
+    }
+
+    /**
+     * @brief Returns true, if the line is invisible: both ends are outside of the same frustum plane or the line
+     * lies completely behind the occluder.
+     */
+    bool isCulled(const glm::vec3& p1, const glm::vec3& p2) const;
+
+  private:
+    glm::vec4 planes[6]; // frustum planes, normals point inside and have unit length
+    glm::vec3 eye = glm::vec3(0.f);
+    float occluder_radius = 0.f;
+};
+
+// ------------------------------------------------------------------------------------------------
+
 /**
  * @brief Creates a list of elements that form a sphere in gl.
  * @param accuracy number of stacks; 1/2 number of sectors
@@ -151,6 +367,9 @@ struct ObjectInfo {
 Object createSphere(const float radius, const glm::vec3 center, const unsigned short accuracy,
                     const glm::vec4 color = glm::vec4(1.f));
 
+constexpr float SATELLITE_RADIUS = 0.007f; // see createSatellite
+constexpr unsigned int ORBIT_VERTICES = 130u; // see createOrbit
+
 /**
  * @brief Creates a list of elements that form a satellite (cube) in gl.
  * @param position Current position of the satellite (in real world coordinates).
@@ -163,7 +382,38 @@ Object createSatellite();
 Object createLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed = false);
 
 /**
- * @brief Creates a list of vertices and colors that form an orbit in gl.
+ * @brief Number of vertices of a line (see createLine).
+ */
+inline size_t lineVertexCount(const bool dashed = false) { return dashed ? 30 : 2; }
+
+/**
+ * @brief Writes the vertices of createLine() to out (lineVertexCount() elements, e.g. mapped GPU memory).
+ */
+void writeLine(VertexData* out, const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed = false);
+void writeLine(LineVertex* out, const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed = false);
+
+/**
+ * @brief Appends lines to the mapped region of a stream buffer. Nothing is allocated: the capacity of the buffer has to
+ * be large enough for all lines of a frame (see lineVertexCount).
+ */
+class LineBatch {
+  public:
+    explicit LineBatch(StreamBuffer<LineVertex>& buffer) : buffer(buffer), first(buffer.size()) {}
+
+    void add(const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color, bool dashed = false) {
+        writeLine(buffer.reserve(lineVertexCount(dashed)), p1, p2, color, dashed);
+    }
+
+    size_t offset() const { return first; } // first vertex of the batch within the region
+    size_t vertexCount() const { return buffer.size() - first; }
+
+  private:
+    StreamBuffer<LineVertex>& buffer;
+    size_t first;
+};
+
+/**
+ * @brief Creates a list of vertices and colors that form an orbit in gl (ORBIT_VERTICES vertices).
  */
 Object createOrbit(const Satellite& orbit, const float scale, const glm::vec3 center);
 
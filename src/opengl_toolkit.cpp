@@ -1,9 +1,23 @@
 #include "opengl_toolkit.hpp"
 #include <cassert>
+#include <cctype>
+#include <cstring>
 #include <fstream>
+#include <stdlib.h>
 
 #include <iostream>
 
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define PIPE_MODE "wb"
+#else
+#define PIPE_MODE "w"
+#endif
+
 namespace dmsc {
 namespace tools {
 
@@ -27,13 +41,25 @@ std::string readShader(const std::string& file_name) {
 // ------------------------------------------------------------------------------------------------
 
 GLuint createShader(const std::string& file_name, GLenum shader_type) {
+    return createShader(std::vector<std::string>{file_name}, shader_type);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+GLuint createShader(const std::vector<std::string>& file_names, GLenum shader_type) {
     GLint compile_flag = GL_FALSE;
     GLuint shader = glCreateShader(shader_type);
 
     // Read source code
-    std::string sourcecode = readShader(file_name);
-    const GLchar* source = sourcecode.c_str();
-    glShaderSource(shader, 1, &source, NULL); // read an array of source files
+    std::vector<std::string> sourcecode;
+    std::vector<const GLchar*> sources;
+    for (const auto& file_name : file_names) {
+        sourcecode.push_back(readShader(file_name));
+    }
+    for (const auto& code : sourcecode) {
+        sources.push_back(code.c_str());
+    }
+    glShaderSource(shader, static_cast<GLsizei>(sources.size()), sources.data(), NULL); // read an array of sources
 
     // Compile shader
     glCompileShader(shader);
@@ -42,7 +68,7 @@ GLuint createShader(const std::string& file_name, GLenum shader_type) {
                   &compile_flag); // get infos about the shader object and store it into compile_ok
     if (!compile_flag) {
         debugShaderObject(shader);
-        printf("Error in compiling shader: '%s'!\n", file_name.c_str());
+        printf("Error in compiling shader: '%s'!\n", file_names.front().c_str());
         assert(false);
         exit(EXIT_FAILURE);
     }
@@ -85,5 +111,214 @@ GLuint createProgram(const GLuint vertex_shader, const GLuint fragment_shader) {
     return program;
 }
 
+// ------------------------------------------------------------------------------------------------
+
+BufferStorageProc loadBufferStorage() {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = major > 4 || (major == 4 && minor >= 4);
+
+    GLint extension_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+    for (GLint i = 0; i < extension_count && !supported; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        supported = extension != nullptr && std::strcmp(extension, "GL_ARB_buffer_storage") == 0;
+    }
+
+    if (!supported) {
+        return nullptr;
+    }
+    return reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"));
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool FrameWriter::isFramePattern(const std::string& pattern) {
+    size_t conversions = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != '%') {
+            continue;
+        }
+        if (++i < pattern.size() && pattern[i] == '%') {
+            continue; // literal '%'
+        }
+
+        // %[flags][width][.precision](d|i|u)
+        while (i < pattern.size() && pattern[i] != '\0' && std::strchr("-+ #0", pattern[i]) != nullptr) {
+            i++;
+        }
+        while (i < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+            i++;
+        }
+        if (i < pattern.size() && pattern[i] == '.') {
+            i++;
+            while (i < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[i]))) {
+                i++;
+            }
+        }
+        if (i >= pattern.size() || pattern[i] == '\0' || std::strchr("diu", pattern[i]) == nullptr) {
+            return false;
+        }
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+FrameWriter::FrameWriter(const std::string& output, const int width, const int height)
+    : output(output)
+    , width(width)
+    , height(height) {
+    if (!output.empty() && output[0] == '|') {
+        pipe = popen(output.c_str() + 1, PIPE_MODE);
+        if (pipe == nullptr) {
+            printf("Could not run '%s'.\n", output.c_str() + 1);
+            assert(false);
+            exit(EXIT_FAILURE);
+        }
+    } else if (!isFramePattern(output)) {
+        // the pattern is passed to snprintf, so anything else would be undefined behaviour
+        printf("'%s' must contain exactly one integer conversion for the frame number (e.g. %%05d).\n",
+               output.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+FrameWriter::~FrameWriter() {
+    if (pipe != nullptr) {
+        pclose(pipe); // waits for the command to finish
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void FrameWriter::write(const unsigned char* pixels, const unsigned int frame) {
+    FILE* file = pipe;
+    if (file == nullptr) {
+        std::vector<char> file_name(snprintf(nullptr, 0, output.c_str(), frame) + 1);
+        snprintf(file_name.data(), file_name.size(), output.c_str(), frame);
+        file = fopen(file_name.data(), "wb");
+        if (file == nullptr) {
+            printf("Could not write '%s'.\n", file_name.data());
+            assert(false);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(file, "P6\n%d %d\n255\n", width, height);
+    }
+
+    // images begin with the top row
+    size_t row_size = 3 * static_cast<size_t>(width); // [byte]
+    for (int y = height - 1; y >= 0; y--) {
+        fwrite(pixels + y * row_size, 1, row_size, file);
+    }
+
+    if (file != pipe) {
+        fclose(file);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void FrameProfiler::init() { glGenQueries(QUERY_SETS * STAGE_COUNT, &queries[0][0]); }
+
+// ------------------------------------------------------------------------------------------------
+
+void FrameProfiler::release() {
+    if (queries[0][0] != 0u) {
+        glDeleteQueries(QUERY_SETS * STAGE_COUNT, &queries[0][0]);
+    }
+    *this = FrameProfiler();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void FrameProfiler::beginFrame() {
+    // previous frame
+    unsigned int previous_idx = history_idx;
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        cpu_history[s][previous_idx] = cpu_frame[s];
+        gpu_history[s][previous_idx] = 0.f; // until the results are read
+        cpu_frame[s] = 0.f;
+    }
+    history_idx = (history_idx + 1) % HISTORY;
+    last = current;
+    current = FrameCounts();
+
+    // read the results of all sets that are available, the others stay pending
+    for (unsigned int set = 0; set < QUERY_SETS; set++) {
+        for (size_t s = 0; s < STAGE_COUNT; s++) {
+            if (!issued[set][s]) {
+                continue;
+            }
+
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(queries[set][s], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_TRUE) {
+                GLuint64 elapsed = 0; // [ns]
+                glGetQueryObjectui64v(queries[set][s], GL_QUERY_RESULT, &elapsed);
+                gpu_history[s][query_frame[set]] = static_cast<float>(elapsed) * 1e-6f;
+                issued[set][s] = false;
+            }
+        }
+    }
+
+    // a pending set must not be started again - the GPU is QUERY_SETS frames behind, so this frame is not measured
+    unsigned int next_set = (query_set + 1) % QUERY_SETS;
+    measuring_frame = !isPending(next_set);
+    if (measuring_frame) {
+        query_set = next_set;
+        query_frame[query_set] = history_idx;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void FrameProfiler::beginGPU(const FrameStage stage) {
+    size_t s = static_cast<size_t>(stage);
+    if (queries[0][0] == 0u || !measuring_frame || measuring_gpu || issued[query_set][s]) {
+        return; // a query is never restarted before its result was read
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[query_set][s]);
+    issued[query_set][s] = true;
+    measuring_gpu = true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void FrameProfiler::endGPU() {
+    if (measuring_gpu) {
+        glEndQuery(GL_TIME_ELAPSED);
+        measuring_gpu = false;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+const char* FrameProfiler::name(const FrameStage stage) {
+    switch (stage) {
+    case FrameStage::POSITIONS:
+        return "Positions";
+    case FrameStage::SATELLITES:
+        return "Satellites";
+    case FrameStage::ISL_NETWORK:
+        return "ISL network";
+    case FrameStage::LINES:
+        return "Lines";
+    case FrameStage::UPLOAD:
+        return "Upload";
+    case FrameStage::SCENE:
+        return "Scene";
+    case FrameStage::GUI:
+        return "GUI";
+    default:
+        return "unknown";
+    }
+}
+
 } // namespace tools
 } // namespace dmsc
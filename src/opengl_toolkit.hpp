@@ -1,12 +1,29 @@
 #ifndef DMSC_OPENGL_TOOLKIT
 #define DMSC_OPENGL_TOOLKIT
 
+#include <algorithm>
+#include <chrono>
 #include <glad/glad.h>
+#include <stdio.h>
 #include <string>
+#include <vector>
+
+// glBufferStorage (GL 4.4 or GL_ARB_buffer_storage) is not part of the GL 4.2 loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
 
 namespace dmsc {
 namespace tools {
 
+using BufferStorageProc = void(APIENTRYP)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
 /**
  * @brief Read source code for a shader from a local file.
  * @param file_name Relative path to the file.
@@ -22,6 +39,15 @@ std::string readShader(const std::string& file_name);
  */
 GLuint createShader(const std::string& file_name, GLenum shader_type);
 
+/**
+ * @brief Compile the source code of several files into one shader (e.g. a shader and the functions it uses).
+ * @param file_names Relative paths to the files. The sources are concatenated in the given order, so only the first
+ * file contains the version directive.
+ * @param shader_type GL constant that determines the shader type.
+ * @return A compiled shader object.
+ */
+GLuint createShader(const std::vector<std::string>& file_names, GLenum shader_type);
+
 /**
  * @brief Link two shader to an opengl program.
  * @param vertex_shader
@@ -35,6 +61,162 @@ GLuint createProgram(const GLuint vertex_shader, const GLuint fragment_shader);
  */
 void debugShaderObject(const GLuint shader_object);
 
+/**
+ * @brief Loads glBufferStorage from the current context.
+ * @return nullptr, if the context supports neither GL 4.4 nor GL_ARB_buffer_storage.
+ */
+BufferStorageProc loadBufferStorage();
+
+/**
+ * @brief Writes RGB frames to binary PPM files or to the standard input of a command (e.g. a video encoder).
+ */
+class FrameWriter {
+  public:
+    /**
+     * @param output printf pattern of the file names with the frame number as its only argument (e.g.
+     * "frame_%05d.ppm"), checked by isFramePattern. If it begins with '|', the rest is run as a command and the raw
+     * frames are written to it.
+     */
+    FrameWriter(const std::string& output, const int width, const int height);
+    ~FrameWriter();
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    /**
+     * @brief Writes a frame as read by glReadPixels (GL_RGB, GL_UNSIGNED_BYTE, pack alignment 1; bottom row first).
+     */
+    void write(const unsigned char* pixels, const unsigned int frame);
+
+    /**
+     * @brief Returns true, if the printf pattern contains exactly one conversion and it is an integer conversion
+     * (d, i or u with optional flags, width and precision). "%%" is allowed.
+     */
+    static bool isFramePattern(const std::string& pattern);
+
+  private:
+    std::string output;
+    int width;
+    int height;
+    FILE* pipe = nullptr;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Parts of a frame measured by the FrameProfiler.
+ */
+enum class FrameStage {
+    POSITIONS,   // positions of all satellites (orbit table or propagator)
+    SATELLITES,  // recalculateOrbitPositions() or recalculateGPUAnimation()
+    ISL_NETWORK, // recalculateISLNetwork()
+    LINES,       // the rest of recalculateLines()
+    UPLOAD,      // unmapping and flushing the stream buffers
+    SCENE,       // draw calls of renderScene()
+    GUI,         // draw calls of ImGui
+    COUNT,
+};
+
+/**
+ * @brief CPU and GPU time of the stages of the last frames and the amount of work of the last frame.
+ *
+ * The GPU time is measured with GL_TIME_ELAPSED queries. There are QUERY_SETS sets of queries that are used in turns
+ * (like the regions of the stream buffers) and the results are read as soon as they are available, without waiting
+ * for them. A set is only used again after all of its results were read. If the GPU is so far behind that the next set
+ * is still pending, the GPU times of that frame are not measured (they stay 0).
+ */
+class FrameProfiler {
+  public:
+    static constexpr unsigned int HISTORY = 120; // frames in the histograms
+    static constexpr unsigned int QUERY_SETS = 4;
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(FrameStage::COUNT);
+
+    /**
+     * @brief Work of one frame.
+     */
+    struct FrameCounts {
+        size_t draw_calls = 0;
+        size_t instances = 0;      // of the instanced draw calls
+        size_t uploaded_bytes = 0; // written into GPU buffers
+    };
+
+    /**
+     * @brief Measures the CPU time of a stage until the scope ends.
+     */
+    class ScopedStage {
+      public:
+        ScopedStage(FrameProfiler& profiler, const FrameStage stage)
+            : profiler(profiler)
+            , stage(stage)
+            , begin(std::chrono::steady_clock::now()) {}
+        ~ScopedStage() { profiler.addCPUTime(stage, std::chrono::steady_clock::now() - begin); }
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+      private:
+        FrameProfiler& profiler;
+        FrameStage stage;
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    /**
+     * @brief Creates the queries. Requires a current context.
+     */
+    void init();
+    void release();
+
+    /**
+     * @brief Finishes the previous frame: its times are appended to the histories and the available GPU results are
+     * read.
+     */
+    void beginFrame();
+
+    void addCPUTime(const FrameStage stage, const std::chrono::steady_clock::duration duration) {
+        cpu_frame[static_cast<size_t>(stage)] += std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    /**
+     * @brief Measures the GPU time of the commands between beginGPU() and endGPU(). The measured ranges must not
+     * overlap.
+     */
+    void beginGPU(const FrameStage stage);
+    void endGPU();
+
+    void countDraw(const size_t instances) {
+        current.draw_calls++;
+        current.instances += instances;
+    }
+    void countUpload(const size_t bytes) { current.uploaded_bytes += bytes; }
+
+    /**
+     * @brief [ms] of the last HISTORY frames, the oldest frame is at historyOffset().
+     */
+    const float* cpuHistory(const FrameStage stage) const { return cpu_history[static_cast<size_t>(stage)]; }
+    const float* gpuHistory(const FrameStage stage) const { return gpu_history[static_cast<size_t>(stage)]; }
+    int historyOffset() const { return static_cast<int>(history_idx); }
+    const FrameCounts& lastFrame() const { return last; }
+
+    static const char* name(const FrameStage stage);
+
+  private:
+    bool isPending(const unsigned int set) const {
+        return std::find(issued[set], issued[set] + STAGE_COUNT, true) != issued[set] + STAGE_COUNT;
+    }
+
+    GLuint queries[QUERY_SETS][STAGE_COUNT] = {};
+    bool issued[QUERY_SETS][STAGE_COUNT] = {}; // the query was started since its last result was read
+    unsigned int query_frame[QUERY_SETS] = {}; // entry of the histories of the frame that used the set
+    unsigned int query_set = 0;                // set of the current frame
+    bool measuring_frame = true;               // the set of the current frame was free
+    bool measuring_gpu = false;
+
+    float cpu_frame[STAGE_COUNT] = {}; // [ms] of the current frame
+    float cpu_history[STAGE_COUNT][HISTORY] = {};
+    float gpu_history[STAGE_COUNT][HISTORY] = {};
+    unsigned int history_idx = 0; // next entry of the histories
+    FrameCounts current;
+    FrameCounts last;
+};
+
 } // namespace tools
 } // namespace dmsc
 
@@ -10,18 +10,90 @@
 #include "stb_image.h"
 #include <algorithm>
 #include <iostream>
+#include <numeric>
 
 namespace dmsc {
 
 using OpenGLPrimitives::GLBuffer;
 using OpenGLPrimitives::Object;
+using OpenGLPrimitives::LineBatch;
+using OpenGLPrimitives::LineVertex;
 using OpenGLPrimitives::ObjectInfo;
 using OpenGLPrimitives::VertexData;
+using OpenGLPrimitives::ViewCulling;
 using namespace tools;
 
+namespace {
+
+/**
+ * @brief Initializes GLFW and creates the window with an OpenGL 4.2 context. GLFW is terminated again, if this fails.
+ * @param headless Use GLFW's null platform with an EGL context (GLFW 3.4), so no display server is needed. Only for
+ * offscreen windows. The EGL implementation has to support surfaceless contexts (EGL_MESA_platform_surfaceless, e.g.
+ * Mesa or the NVIDIA driver).
+ */
+GLFWwindow* createWindow(const bool offscreen, const bool headless) {
+#ifdef GLFW_PLATFORM_NULL
+    if (headless && !glfwPlatformSupported(GLFW_PLATFORM_NULL)) {
+        return NULL;
+    }
+    glfwInitHint(GLFW_PLATFORM, headless ? GLFW_PLATFORM_NULL : GLFW_ANY_PLATFORM);
+#else
+    if (headless) {
+        return NULL; // the null platform needs GLFW 3.4
+    }
+#endif
+    if (!glfwInit())
+        return NULL;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (offscreen) {
+        // the window is never shown, the frames are rendered into a multisampled framebuffer object (see record)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    } else {
+        glfwWindowHint(GLFW_SAMPLES, 4);
+    }
+#ifdef GLFW_PLATFORM_NULL
+    if (headless) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
+#endif
+
+    // Create window with graphics context
+    GLFWwindow* window = glfwCreateWindow(1280, 720, "Dynamic Minimum Scan Cover - Visualizer", NULL, NULL);
+    if (window == NULL) {
+        glfwTerminate();
+    }
+    return window;
+}
+
 // ------------------------------------------------------------------------------------------------
 
-OpenGLWidget::OpenGLWidget() { init(); }
+/**
+ * @brief Calls visit with the scans of the given scan cover in time order - with a MappedScanCover of the file, if the
+ * scans were spilled (see ScanCover::spill), otherwise with the scan cover itself.
+ */
+template <typename Visitor>
+void visitScans(const ScanCover& scan_cover, Visitor&& visit) {
+    if (!scan_cover.isSpilled()) {
+        visit(scan_cover);
+        return;
+    }
+
+    MappedScanCover mapped;
+    if (!mapped.open(scan_cover.getSpillFile())) {
+        printf("The spilled scan cover %s can not be read.\n", scan_cover.getSpillFile().c_str());
+        return;
+    }
+    visit(mapped);
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+
+OpenGLWidget::OpenGLWidget(const bool offscreen) { init(offscreen); }
 
 // ------------------------------------------------------------------------------------------------
 
@@ -29,24 +101,23 @@ OpenGLWidget::~OpenGLWidget() { destroy(); }
 
 // ------------------------------------------------------------------------------------------------
 
-void OpenGLWidget::init() {
+void OpenGLWidget::init(const bool offscreen) {
+    this->offscreen = offscreen;
+
     // Setup window
     glfwSetErrorCallback(glfw_error_callback);
-    if (!glfwInit())
-        return;
-
-    const char* glsl_version = "#version 420";
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
-
-    // Create window with graphics context
-    window = glfwCreateWindow(1280, 720, "Dynamic Minimum Scan Cover - Visualizer", NULL, NULL);
+    window = offscreen ? createWindow(true, true) : NULL;
+    if (window == NULL) {
+        // interactive or no headless context available - the (hidden) window needs a display server (e.g. Xvfb)
+        window = createWindow(offscreen, false);
+    }
     if (window == NULL)
         return;
+    const char* glsl_version = "#version 420";
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1); // Enable vsync
+    if (!offscreen) {
+        glfwSwapInterval(1); // Enable vsync
+    }
 
     // Resize event
     glfwSetWindowSizeCallback(window,
@@ -152,12 +223,21 @@ void OpenGLWidget::init() {
     satellite_prog = createProgram(satellite_vert_shader, fragment_shader);
     earth_prog = createProgram(vertex_shader, earth_frag_shader);
     shaded_prog = createProgram(satellite_vert_shader, shaded_frag_shader);
-
-    // bind uniform vbo to programs
-    glGenBuffers(1, &vbo_uniforms);
+    using Sources = std::vector<std::string>; // the orbit functions are appended to the shaders
+    GLuint satellite_orbit_shader = createShader(Sources{"shader/satellite_orbit.vert", "shader/orbit.glsl"},
+                                                 GL_VERTEX_SHADER);
+    GLuint isl_shader = createShader(Sources{"shader/isl.vert", "shader/orbit.glsl"}, GL_VERTEX_SHADER);
+    satellite_orbit_prog = createProgram(satellite_orbit_shader, fragment_shader);
+    isl_prog = createProgram(isl_shader, fragment_shader);
+
+    // bind uniform vbo to programs (the region of the current frame is bound in recalculate)
+    buffer_storage = loadBufferStorage();
+    profiler.init();
+    GLint uniform_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+    buffer_uniforms.allocate(GL_UNIFORM_BUFFER, 5, buffer_storage, std::max<size_t>(uniform_alignment, 1));
     GLuint index = glGetUniformBlockIndex(basic_program, "Global");
     glUniformBlockBinding(basic_program, index, 1);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 1, vbo_uniforms);
     index = glGetUniformBlockIndex(satellite_prog, "Global");
     glUniformBlockBinding(satellite_prog, index, 1);
     index = glGetUniformBlockIndex(earth_prog, "Global");
@@ -165,15 +245,26 @@ void OpenGLWidget::init() {
     index = glGetUniformBlockIndex(shaded_prog, "Global");
     glUniformBlockBinding(shaded_prog, index, 1);
 
+    // the orbital elements are read from texture unit 2 (see orbit.glsl)
+    for (GLuint program : {satellite_orbit_prog, isl_prog}) {
+        index = glGetUniformBlockIndex(program, "Global");
+        glUniformBlockBinding(program, index, 1);
+        glProgramUniform1i(program, glGetUniformLocation(program, "orbit_elements"), 2);
+        glProgramUniform1f(program, glGetUniformLocation(program, "world_scale"), real_world_scale);
+    }
+
     // create storage buffer
     glGenBuffers(1, &vbo_static);
     glGenBuffers(1, &ibo_static);
-    buffer_transformations = GLBuffer<glm::mat4>(GL_DYNAMIC_DRAW);
-    buffer_transformations.gen();
-    buffer_satellite_color = GLBuffer<glm::vec3>(GL_DYNAMIC_DRAW);
-    buffer_satellite_color.gen();
-    buffer_lines = GLBuffer<VertexData>(GL_DYNAMIC_DRAW);
-    buffer_lines.gen();
+    buffer_orbit_elements = GLBuffer<glm::vec4>(GL_STATIC_DRAW);
+    buffer_orbit_elements.gen();
+    buffer_isl_satellites = GLBuffer<glm::uvec2>(GL_STATIC_DRAW);
+    buffer_isl_satellites.gen();
+    buffer_orbit_color = GLBuffer<glm::vec3>(GL_DYNAMIC_DRAW);
+    buffer_orbit_color.gen();
+    buffer_isl_color = GLBuffer<glm::vec4>(GL_DYNAMIC_DRAW);
+    buffer_isl_color.gen();
+    glGenTextures(1, &orbit_elements_texture);
 
     // create vao
     glGenVertexArrays(1, &vao);
@@ -188,20 +279,6 @@ void OpenGLWidget::init() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 7));
     glEnableVertexAttribArray(3); // normals
     glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 9));
-    glBindBuffer(GL_ARRAY_BUFFER, buffer_transformations.buffer_idx); // object transformations
-    glEnableVertexAttribArray(4);
-    glEnableVertexAttribArray(5);
-    glEnableVertexAttribArray(6);
-    glEnableVertexAttribArray(7);
-    // maximum size for vertexAttr is 4. So we split the 4x4matrix into 4x vec4
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(0));
-    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 4));
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 8));
-    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 12));
-    glVertexAttribDivisor(4, 1); // update transformation attr. every 1 instance instead of every vertex
-    glVertexAttribDivisor(5, 1);
-    glVertexAttribDivisor(6, 1);
-    glVertexAttribDivisor(7, 1);
     glBindVertexArray(0);
 
     // create vao for satellites
@@ -217,36 +294,40 @@ void OpenGLWidget::init() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 7));
     glEnableVertexAttribArray(3); // normals
     glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 9));
-    glBindBuffer(GL_ARRAY_BUFFER, buffer_transformations.buffer_idx); // object transformations
-    glEnableVertexAttribArray(4);
-    glEnableVertexAttribArray(5);
-    glEnableVertexAttribArray(6);
-    glEnableVertexAttribArray(7);
-    // maximum size for vertexAttr is 4. So we split the 4x4matrix into 4x vec4
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(0));
-    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 4));
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 8));
-    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 12));
-    glVertexAttribDivisor(4, 1); // update transformation attr. every 1 instance instead of every vertex
-    glVertexAttribDivisor(5, 1);
-    glVertexAttribDivisor(6, 1);
-    glVertexAttribDivisor(7, 1);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer_satellite_color.buffer_idx); // dynamic satellite color
-    glBufferData(GL_ARRAY_BUFFER, 0, 0,
-                 GL_STREAM_DRAW); // push data
-    glEnableVertexAttribArray(8);
-    glVertexAttribPointer(8, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
-    glVertexAttribDivisor(8, 1);
     glBindVertexArray(0);
 
-    // create vao for lines
+    // create vao for lines (the vertices are part of the stream buffers)
     glGenVertexArrays(1, &vao_lines);
-    glBindVertexArray(vao_lines);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer_lines.buffer_idx);
+    allocateStreamBuffers(1, 1);
+
+    // create vao for satellites on the GPU orbits (no transformations, the position is calculated in the shader)
+    glGenVertexArrays(1, &vao_orbit_satellites);
+    glBindVertexArray(vao_orbit_satellites);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_static);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_static);
     glEnableVertexAttribArray(0); // vertices
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), 0);
     glEnableVertexAttribArray(1); // colors
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 3));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 3));
+    glEnableVertexAttribArray(2); // texture
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 7));
+    glEnableVertexAttribArray(3); // normals
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(sizeof(GL_FLOAT) * 9));
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_orbit_color.buffer_idx); // dynamic satellite color
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    glVertexAttribDivisor(8, 1);
+    glBindVertexArray(0);
+
+    // create vao for ISLs on the GPU orbits
+    glGenVertexArrays(1, &vao_orbit_isl);
+    glBindVertexArray(vao_orbit_isl);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_isl_satellites.buffer_idx);
+    glEnableVertexAttribArray(0); // satellite indices
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(glm::uvec2), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_isl_color.buffer_idx);
+    glEnableVertexAttribArray(1); // colors
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0);
     glBindVertexArray(0);
 
     // load textures
@@ -288,39 +369,68 @@ void OpenGLWidget::loadTextures(const char* uniform_name, const char* file, GLui
 
 // ------------------------------------------------------------------------------------------------
 
-void OpenGLWidget::show(const PhysicalInstance& instance, const Animation& animation, const float t0) {
-    prepareInstance(instance);
+void OpenGLWidget::show(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation,
+                        const float t0) {
+    prepareInstance(std::move(instance));
     this->animation = animation;
+    prepareAnimation();
     sim_time = t0;
     openWindow();
 }
 
 // ------------------------------------------------------------------------------------------------
 
-void OpenGLWidget::show(const PhysicalInstance& instance, const float t0) { show(instance, Animation(), t0); }
+void OpenGLWidget::show(std::shared_ptr<const PhysicalInstance> instance, const float t0) {
+    show(std::move(instance), Animation(), t0);
+}
 
 // ------------------------------------------------------------------------------------------------
 
-void OpenGLWidget::show(const PhysicalInstance& instance, const DmscSolution& solution, const float t0) {
-    Animation anim = animateScanCover(instance, solution.scan_cover);
-    show(instance, anim, t0);
+void OpenGLWidget::show(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                        const float t0) {
+    Animation anim = animateScanCover(*instance, solution.scan_cover);
+    show(std::move(instance), anim, t0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
-void OpenGLWidget::show(const PhysicalInstance& instance, const FreezeTagSolution& solution, const float t0) {
-    Animation anim = animateScanCover(instance, solution.scan_cover);
+void OpenGLWidget::show(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                        const float t0) {
+    Animation anim = animateFreezeTag(*instance, solution);
+    show(std::move(instance), anim, t0);
+}
 
-    // build timeline for satellite orientations and edge order
-    float scan_time = 0.f;
-    std::multimap<float, size_t> edge_order; // which edges are scanned at a given time (multiple edges can be scanned
-                                             // at the same time -> multimap)
-    for (const auto& scan : solution.scan_cover) {
-        float t = scan.second;              // time when edge is scheduled
-        scan_time = std::max(scan_time, t); // find time when all edges were scanned
-        // fill edge order
-        edge_order.insert({t, scan.first});
-    }
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::record(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation,
+                          const RenderOptions& options) {
+    prepareInstance(std::move(instance));
+    this->animation = animation;
+    prepareAnimation();
+    renderOffscreen(options);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::record(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                          const RenderOptions& options) {
+    Animation anim = animateScanCover(*instance, solution.scan_cover);
+    record(std::move(instance), anim, options);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::record(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                          const RenderOptions& options) {
+    Animation anim = animateFreezeTag(*instance, solution);
+    record(std::move(instance), anim, options);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+Animation OpenGLWidget::animateFreezeTag(const PhysicalInstance& instance, const FreezeTagSolution& solution) {
+    Animation anim = animateScanCover(instance, solution.scan_cover);
+    float scan_time = scanTime(solution.scan_cover); // time when all edges were scanned
 
     // when does the message recieves a satellite
     std::map<size_t, float> satellites_done;
@@ -328,21 +438,25 @@ void OpenGLWidget::show(const PhysicalInstance& instance, const FreezeTagSolutio
         satellites_done[sat] = 0.f;
     }
 
-    for (const auto& it : edge_order) {
-        // does one of the satellites already contain the message?
-        const InterSatelliteLink& isl = instance.getISLs().at(it.second);
-        auto res_1 = satellites_done.find(isl.getV1Idx());
-        auto res_2 = satellites_done.find(isl.getV2Idx());
-
-        // if only one satellite carries the message, the message will be transferred
-        if (res_1 == satellites_done.end() && res_2 != satellites_done.end()) {
-            // sat 2 carries the message
-            satellites_done[isl.getV1Idx()] = it.first; // time when sat 1 recieves the message
-        } else if (res_1 != satellites_done.end() && res_2 == satellites_done.end()) {
-            // sat 1 carries the message
-            satellites_done[isl.getV2Idx()] = it.first; // time when sat 2 recieves the message
+    // the scans are sorted by time
+    visitScans(solution.scan_cover, [&](const auto& scans) {
+        for (size_t i = 0; i < scans.size(); i++) {
+            float t = scans.time(i);
+            // does one of the satellites already contain the message?
+            const InterSatelliteLink& isl = instance.getISLs().at(scans.edgeIdx(i));
+            auto res_1 = satellites_done.find(isl.getV1Idx());
+            auto res_2 = satellites_done.find(isl.getV2Idx());
+
+            // if only one satellite carries the message, the message will be transferred
+            if (res_1 == satellites_done.end() && res_2 != satellites_done.end()) {
+                // sat 2 carries the message
+                satellites_done[isl.getV1Idx()] = t; // time when sat 1 recieves the message
+            } else if (res_1 != satellites_done.end() && res_2 == satellites_done.end()) {
+                // sat 1 carries the message
+                satellites_done[isl.getV2Idx()] = t; // time when sat 2 recieves the message
+            }
         }
-    }
+    });
 
     // animate satellite color
     for (const auto& sat : satellites_done) {
@@ -350,87 +464,79 @@ void OpenGLWidget::show(const PhysicalInstance& instance, const FreezeTagSolutio
             sat.first, sat.second, scan_time, AnimationDetails(true, glm::vec4(0.f, 1.f, 0.f, 1.f)));
     }
 
-    show(instance, anim, t0);
+    return anim;
 }
 
 // ------------------------------------------------------------------------------------------------
 
 Animation OpenGLWidget::animateScanCover(const PhysicalInstance& instance, const ScanCover& scan_cover) {
     Animation anim;
-
-    std::multimap<float, size_t> edge_order; // which edges are scanned at a given time (multiple edges can be scanned
-                                             // at the same time -> multimap)
-    float scan_time = 0.f;
-
-    // build timeline for satellite orientations and edge order
-    for (const auto& scan : scan_cover) {
-        float t = scan.second;              // time when edge is scheduled
-        scan_time = std::max(scan_time, t); // find time when all edges were scanned
-        const InterSatelliteLink& isl = instance.getISLs().at(scan.first);
-        glm::vec3 needed_orientation = isl.getOrientation(t);
-
-        glm::vec3 sat1 = instance.getSatellites()[isl.getV1Idx()].cartesian_coordinates(t);
-        glm::vec3 sat2 = instance.getSatellites()[isl.getV2Idx()].cartesian_coordinates(t);
-        float distance = glm::length((sat2 - sat1) / real_world_scale);
-
-        // add corresponding events for both satellites where they have to face in the needed
-        // direction in order to perform the scan
-        bool res_1 = anim.addOrientationAnimation(isl.getV1Idx(), t, OrientationDetails(needed_orientation, distance));
-        bool res_2 = anim.addOrientationAnimation(isl.getV2Idx(), t, OrientationDetails(-needed_orientation, distance));
-
-        if (!res_1 || !res_2) {
-            printf("The needed orientation for satellites can not be applied at t=%f!\n", t);
-        }
-
-        // fill edge order
-        edge_order.insert({t, scan.first});
-    }
-
-    // animate isl network
-    for (size_t i = 0; i < instance.islCount(); i++) {
-        // hide ISL-edges that are not part of the scan cover (anymore)
-        auto range = scan_cover.equal_range(i);
-        // edge is not part of the scan cover -> hide it
-        if (range.first == scan_cover.end()) {
-            anim.addISLAnimation(i, 0.f, scan_time, AnimationDetails(false));
-            continue;
-        } else {
-            float latest_use = 0.f;
-            for (auto it = range.first; it != range.second; ++it) {
-                latest_use = std::max(latest_use, it->second);
+    float scan_time = scanTime(scan_cover); // time when all edges were scanned
+    std::vector<float> latest_use(instance.islCount(), -1.f); // [sec] last scan of every ISL (-1: never scanned)
+
+    // the scans are sorted by time, so neither the orientations nor the order of the edges have to be sorted
+    visitScans(scan_cover, [&](const auto& scans) {
+        // build timeline for satellite orientations
+        for (size_t i = 0; i < scans.size(); i++) {
+            float t = scans.time(i); // time when edge is scheduled
+            uint32_t edge_idx = scans.edgeIdx(i);
+            const InterSatelliteLink& isl = instance.getISLs().at(edge_idx);
+            glm::vec3 needed_orientation = isl.getOrientation(t);
+
+            glm::vec3 sat1 = instance.getSatellites()[isl.getV1Idx()].cartesian_coordinates(t);
+            glm::vec3 sat2 = instance.getSatellites()[isl.getV2Idx()].cartesian_coordinates(t);
+            float distance = glm::length((sat2 - sat1) / real_world_scale);
+
+            // add corresponding events for both satellites where they have to face in the needed
+            // direction in order to perform the scan
+            bool res_1 =
+                anim.addOrientationAnimation(isl.getV1Idx(), t, OrientationDetails(needed_orientation, distance));
+            bool res_2 =
+                anim.addOrientationAnimation(isl.getV2Idx(), t, OrientationDetails(-needed_orientation, distance));
+
+            if (!res_1 || !res_2) {
+                printf("The needed orientation for satellites can not be applied at t=%f!\n", t);
             }
-            anim.addISLAnimation(i, latest_use, scan_time, AnimationDetails(false));
+            latest_use[edge_idx] = std::max(0.f, t);
         }
-    }
 
-    // change color for the next edges that will be scanned
-    std::vector<size_t> next_edges;
-    float te = 0.f, t = 0.f;
-    for (const auto& it : edge_order) {
-        if (it.first == t) { // this edge will also be visible next
-            next_edges.push_back(it.second);
+        // animate isl network
+        for (size_t i = 0; i < instance.islCount(); i++) {
+            // hide ISL-edges that are not part of the scan cover (anymore)
+            if (latest_use[i] < 0.f) {
+                // edge is not part of the scan cover -> hide it
+                anim.addISLAnimation(i, 0.f, scan_time, AnimationDetails(false));
+            } else {
+                anim.addISLAnimation(i, latest_use[i], scan_time, AnimationDetails(false));
+            }
         }
 
-        if (it.first > t) { // edge that will be active later
-                            // 1. animate edges that came before
-            AnimationDetails d(true, glm::vec4(1.0f, .75f, 0.0f, 1.f));
-            for (const auto& edge_idx : next_edges) {
-                anim.addISLAnimation(edge_idx, te, t, d);
+        // change color for the next edges that will be scanned
+        AnimationDetails d(true, glm::vec4(1.0f, .75f, 0.0f, 1.f));
+        size_t next_begin = 0; // first scan of the edges that will be scanned next
+        float te = 0.f, t = 0.f;
+        for (size_t i = 0; i < scans.size(); i++) {
+            float t_scan = scans.time(i);
+            if (t_scan < t) { // scans before t=0 are never shown as next edges
+                next_begin = i + 1;
+            } else if (t_scan > t) { // edge that will be active later
+                // 1. animate edges that came before
+                for (size_t j = next_begin; j < i; j++) {
+                    anim.addISLAnimation(scans.edgeIdx(j), te, t, d);
+                }
+
+                // prepare the next edges
+                te = t;
+                t = t_scan;
+                next_begin = i;
             }
-            next_edges.clear();
-
-            // prepare the next edges
-            te = t;
-            t = it.first;
-            next_edges.push_back(it.second);
         }
-    }
 
-    // change color for the last edges that will be scanned
-    AnimationDetails d(true, glm::vec4(1.0f, .75f, 0.0f, 1.f));
-    for (const auto& edge_idx : next_edges) {
-        anim.addISLAnimation(edge_idx, te, t, d);
-    }
+        // change color for the last edges that will be scanned
+        for (size_t j = next_begin; j < scans.size(); j++) {
+            anim.addISLAnimation(scans.edgeIdx(j), te, t, d);
+        }
+    });
 
     return anim;
 }
@@ -455,7 +561,12 @@ void OpenGLWidget::openWindow() {
 
         // render new frame
         renderScene();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            FrameProfiler::ScopedStage stage(profiler, FrameStage::GUI);
+            profiler.beginGPU(FrameStage::GUI);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            profiler.endGPU();
+        }
 
         // swap
         glfwSwapBuffers(window);
@@ -464,11 +575,114 @@ void OpenGLWidget::openWindow() {
 
 // ------------------------------------------------------------------------------------------------
 
+void OpenGLWidget::renderOffscreen(const RenderOptions& options) {
+    if (!offscreen || window == nullptr) {
+        printf("The widget has to be created for offscreen rendering.\n");
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+    const GLsizei width = options.width;
+    const GLsizei height = options.height;
+    const size_t frame_size = 3 * static_cast<size_t>(width) * static_cast<size_t>(height); // [byte] RGB
+
+    // multisampled framebuffer (like the window), resolved into a single sampled one for the readback
+    GLuint framebuffers[2] = {0u, 0u};      // multisampled, resolved
+    GLuint renderbuffers[3] = {0u, 0u, 0u}; // color and depth (multisampled), color (resolved)
+    glGenFramebuffers(2, framebuffers);
+    glGenRenderbuffers(3, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[2]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[1]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[2]);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        printf("Offscreen framebuffer with %d x %d pixels is incomplete.\n", width, height);
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    // asynchronous readback: a frame is copied into a pixel buffer and written, while the next frames are rendered
+    constexpr unsigned int READBACK_FRAMES = 3;
+    GLuint pixel_buffers[READBACK_FRAMES] = {};
+    GLsync readback_fences[READBACK_FRAMES] = {};
+    glGenBuffers(READBACK_FRAMES, pixel_buffers);
+    for (GLuint pixel_buffer : pixel_buffers) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frame_size, nullptr, GL_STREAM_READ);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    FrameWriter writer(options.output, width, height);
+    glm::vec3 clear_color = glm::vec3(0.03f);
+    paused = true; // the time of every frame is set below
+    zoom = options.zoom;
+
+    for (unsigned int i = 0; i < options.frame_count + READBACK_FRAMES - 1; i++) {
+        if (i < options.frame_count) {
+            sim_time = options.t0 + i * options.dt;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+            glViewport(0, 0, width, height);
+            glClearColor(clear_color.x, clear_color.y, clear_color.z, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderScene();
+
+            // resolve and start the copy into the pixel buffer of this frame
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[1]);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[i % READBACK_FRAMES]);
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            readback_fences[i % READBACK_FRAMES] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        // write the oldest frame that is still in flight
+        if (i + 1 >= READBACK_FRAMES) {
+            unsigned int frame = i + 1 - READBACK_FRAMES;
+            GLsync& fence = readback_fences[frame % READBACK_FRAMES];
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[frame % READBACK_FRAMES]);
+            const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame_size, GL_MAP_READ_BIT);
+            writer.write(static_cast<const unsigned char*>(pixels), frame);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteBuffers(READBACK_FRAMES, pixel_buffers);
+    glDeleteRenderbuffers(3, renderbuffers);
+    glDeleteFramebuffers(2, framebuffers);
+}
+
+// ------------------------------------------------------------------------------------------------
+
 void OpenGLWidget::renderScene() {
+    profiler.beginFrame();
     recalculate();
 
-    // for every program (key) a vector with objects is stored
+    FrameProfiler::ScopedStage stage(profiler, FrameStage::SCENE);
+    profiler.beginGPU(FrameStage::SCENE);
+
+    // the data of this frame begins at the first element of the current region of the stream buffers
     for (const auto& obj : scene) {
+        size_t first_instance = obj.gl_vao == vao_satellites ? buffer_transformations.first() : 0;
+        size_t first_vertex = obj.gl_vao == vao_lines ? buffer_lines.first() : 0;
         glUseProgram(obj.gl_program);
         glBindVertexArray(obj.gl_vao);
 
@@ -487,6 +701,7 @@ void OpenGLWidget::renderScene() {
         }
 
         if (obj.enabled) {
+            profiler.countDraw(obj.drawInstanced ? obj.number_instances : 0);
             if (obj.drawInstanced) { // instanced rendering
                 glDrawElementsInstancedBaseVertexBaseInstance(obj.gl_draw_mode,
                                                               static_cast<GLint>(obj.number_elements),
@@ -494,10 +709,10 @@ void OpenGLWidget::renderScene() {
                                                               (void*)(obj.offset_elements),
                                                               static_cast<GLsizei>(obj.number_instances),
                                                               static_cast<GLint>(obj.base_index),
-                                                              static_cast<GLint>(obj.base_instance));
+                                                              static_cast<GLint>(obj.base_instance + first_instance));
             } else if (obj.number_elements == 0) { // direct rendering with vertices
                 glDrawArrays(obj.gl_draw_mode,
-                             static_cast<GLint>(obj.offset_vertices),
+                             static_cast<GLint>(obj.offset_vertices + first_vertex),
                              static_cast<GLsizei>(obj.number_vertices));
             } else { // direct rendering with elements
                 glDrawElementsBaseVertex(obj.gl_draw_mode,
@@ -510,6 +725,13 @@ void OpenGLWidget::renderScene() {
     }
 
     glBindVertexArray(0);
+    profiler.endGPU();
+
+    // the region may be written again, as soon as the GPU passed this fence
+    if (state != EMPTY) {
+        frame_fences[frame_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame_region = (frame_region + 1) % OpenGLPrimitives::StreamStorage::REGIONS;
+    }
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -523,6 +745,7 @@ void OpenGLWidget::recalculate() {
     float diff = ImGui::GetIO().DeltaTime;
     if (!paused)
         sim_time += diff * sim_speed;
+    compiled_animation.seek(sim_time);
 
     // sun rotation
     float sun_angle = sim_time * 0.000290f; // 6h -> one turn around the earth
@@ -551,50 +774,76 @@ void OpenGLWidget::recalculate() {
     projection = glm::perspective(45.0f, 1.0f * viewport[2] / viewport[3], 0.1f, 10.0f);
     glm::mat4 scale = glm::scale(glm::vec3(zoom));
 
+    // wait until the GPU finished the frame that used this region of the stream buffers before
+    GLsync& fence = frame_fences[frame_region];
+    if (fence != nullptr) {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
     // push mvp to VBO
-    glBindBuffer(GL_UNIFORM_BUFFER, vbo_uniforms);
-    glBufferData(GL_UNIFORM_BUFFER, 5 * sizeof(glm::mat4), 0, GL_DYNAMIC_DRAW);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(world_rotation));
-    glBufferSubData(GL_UNIFORM_BUFFER, 1 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
-    glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(projection));
-    glBufferSubData(GL_UNIFORM_BUFFER, 3 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(scale));
-    glBufferSubData(GL_UNIFORM_BUFFER, 4 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(sun_rotation));
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    buffer_uniforms.map(frame_region);
+    glm::mat4* uniforms = buffer_uniforms.reserve(5);
+    uniforms[0] = world_rotation;
+    uniforms[1] = view;
+    uniforms[2] = projection;
+    uniforms[3] = scale;
+    uniforms[4] = sun_rotation;
+    profiler.countUpload(5 * sizeof(glm::mat4));
+    buffer_uniforms.unmap();
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, buffer_uniforms.id(), buffer_uniforms.offset(), 5 * sizeof(glm::mat4));
+
+    // culling and level of detail are done in world coordinates
+    glm::mat4 model = world_rotation * scale;
+    glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(glm::vec3(camera_position), 1.f));
+    culling = ViewCulling(projection * view * model, eye, problem_instance->getRadiusCentralMass() / real_world_scale);
+    updateLevelOfDetail(viewport[3] / 2.f * std::abs(projection[1][1]) / glm::length(glm::vec3(camera_position)));
 
     // #############################
     // # dynamic part of scene
     // #############################
 
-    buffer_satellite_color.values.clear();
-    buffer_transformations.values.clear();
-    recalculateOrbitPositions();
-    recalculateLines();
+    buffer_transformations.map(frame_region);
+    buffer_satellite_color.map(frame_region);
+    buffer_lines.map(frame_region);
 
-    // the buffer for transfomation and color must match (same instance), so we just fill up the color buffer
-    if (buffer_satellite_color.size() < buffer_transformations.size()) {
-        buffer_satellite_color.values.insert(buffer_satellite_color.values.end(),
-                                             buffer_transformations.size() - buffer_satellite_color.size(),
-                                             glm::vec3(-1.f));
+    // the positions are shared by all following builders - if the GPU calculates the orbits, they are only needed for
+    // the scheduled communications and the orientations
+    bool cpu_positions = !gpu_orbits || !problem_instance->scheduled_communications.empty() ||
+                         !animation.satellite_orientations.empty();
+    {
+        FrameProfiler::ScopedStage stage(profiler, FrameStage::POSITIONS);
+        if (!cpu_positions) {
+            satellite_positions.clear();
+        } else if (use_orbit_table) {
+            orbit_table.interpolate(sim_time, satellite_positions);
+        } else {
+            propagator.propagate(sim_time, satellite_positions);
+        }
     }
 
-    // push data to VBO
-    if (buffer_transformations.values.size() != 0) {
-        size_t size_transformation = sizeof(buffer_transformations.values[0]) * buffer_transformations.values.size();
-        glBindBuffer(GL_ARRAY_BUFFER, buffer_transformations.buffer_idx); // set active
-        glBufferData(GL_ARRAY_BUFFER,
-                     size_transformation,
-                     &buffer_transformations.values[0],
-                     GL_STREAM_DRAW); // push data
+    {
+        FrameProfiler::ScopedStage stage(profiler, FrameStage::SATELLITES);
+        if (gpu_orbits) {
+            recalculateGPUAnimation();
+        } else {
+            recalculateOrbitPositions();
+        }
     }
+    recalculateLines();
 
-    if (buffer_satellite_color.values.size() != 0) {
-        size_t size_transformation = sizeof(glm::vec3) * buffer_satellite_color.values.size();
-        glBindBuffer(GL_ARRAY_BUFFER, buffer_satellite_color.buffer_idx); // set active
-        glBufferData(GL_ARRAY_BUFFER,
-                     size_transformation,
-                     &buffer_satellite_color.values[0],
-                     GL_STREAM_DRAW); // push data
-    }
+    // the buffer for transfomation and color must match (same instance), so we just fill up the color buffer
+    buffer_satellite_color.fill(buffer_transformations.size(), glm::vec3(-1.f));
+
+    // only the written part of the regions is flushed
+    FrameProfiler::ScopedStage stage(profiler, FrameStage::UPLOAD);
+    profiler.countUpload(buffer_transformations.size() * sizeof(glm::mat4) +
+                         buffer_satellite_color.size() * sizeof(glm::vec3) + buffer_lines.size() * sizeof(LineVertex));
+    buffer_transformations.unmap();
+    buffer_satellite_color.unmap();
+    buffer_lines.unmap();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -603,102 +852,238 @@ void OpenGLWidget::recalculateOrbitPositions() {
     // move satellites
     glm::mat4 scale = glm::inverse(glm::scale(glm::vec3(zoom))); // ignore zoom
 
-    auto info = getObjectInfo("satellites");
-    if (info != nullptr)
-        info->base_instance = buffer_transformations.size(); // offset
+    size_t base_instance = buffer_transformations.size(); // offset
+    float radius = OpenGLPrimitives::SATELLITE_RADIUS / zoom;
 
     // the buffer for transfomation and color must match (same instance), so we just fill up the color buffer
-    if (buffer_satellite_color.size() < buffer_transformations.size()) {
-        buffer_satellite_color.values.insert(buffer_satellite_color.values.end(),
-                                             buffer_transformations.size() - buffer_satellite_color.size(),
-                                             glm::vec3(-1.f));
-    }
+    buffer_satellite_color.fill(buffer_transformations.size(), glm::vec3(-1.f));
 
-    for (size_t i = 0; i < problem_instance.getSatellites().size(); i++) {
-        const Satellite& o = problem_instance.getSatellites()[i];
-        glm::vec3 position = o.cartesian_coordinates(sim_time) / real_world_scale;
+    for (size_t i = 0; i < problem_instance->getSatellites().size(); i++) {
+        glm::vec3 position = satellite_positions[i] / real_world_scale;
+        if (culling_enabled && culling.isCulled(position, radius)) {
+            continue;
+        }
         glm::mat4 translation = glm::translate(position);
 
-        auto result = animation.getSatelliteAnimation(i, sim_time);
-        if (result.first) {
-            if (!result.second.visible) {
+        const AnimationDetails* details = compiled_animation.getSatelliteAnimation(i);
+        if (details != nullptr) {
+            if (!details->visible) {
                 translation *= glm::scale(glm::vec3(0.f)); // this satellite has to be invisible rn
             }
-            buffer_satellite_color.values.push_back(result.second.color);
+            buffer_satellite_color.push_back(details->color);
         } else {
-            buffer_satellite_color.values.push_back(glm::vec3(-1));
+            buffer_satellite_color.push_back(glm::vec3(-1));
         }
 
-        buffer_transformations.values.push_back(translation * scale);
+        buffer_transformations.push_back(translation * scale);
+    }
+
+    setSatelliteInstances(base_instance, buffer_transformations.size() - base_instance);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::setSatelliteInstances(const size_t base_instance, const size_t instance_count) {
+    ObjectInfo* spheres = getObjectInfo("satellites");
+    ObjectInfo* points = getObjectInfo("satellite_points");
+    if (spheres == nullptr || points == nullptr) {
+        return;
+    }
+
+    // both share the same instances, only one of them is drawn
+    spheres->base_instance = base_instance;
+    points->base_instance = base_instance;
+    spheres->number_instances = satellites_as_points ? 0 : instance_count;
+    points->number_instances = satellites_as_points ? instance_count : 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::updateLevelOfDetail(const float pixels_per_unit) {
+    // the size of the satellites does not depend on the zoom
+    satellites_as_points = OpenGLPrimitives::SATELLITE_RADIUS * pixels_per_unit < 1.f;
+
+    // with n vertices, an orbit deviates from an ellipse by at most r * (1 - cos(pi / n)) pixels
+    ObjectInfo* orbits = getObjectInfo("orbit");
+    if (orbits != nullptr) {
+        float radius = max_orbit_radius * zoom * pixels_per_unit; // [px]
+        float n = static_cast<float>(OpenGLPrimitives::ORBIT_VERTICES / COARSE_ORBIT_STEP);
+        bool coarse = radius * (1.f - std::cos(static_cast<float>(M_PI) / n)) < .5f;
+        orbits->offset_elements = orbit_offset_elements + (coarse ? orbit_elements[0] * sizeof(GLuint) : 0);
+        orbits->number_elements = orbit_elements[coarse ? 1 : 0];
     }
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void OpenGLWidget::recalculateISLNetwork() {
+    if (gpu_orbits) {
+        return; // static vertices, see recalculateGPUAnimation()
+    }
+
     auto info = getObjectInfo("isl_network");
     if (info == nullptr) {
         printf("Object info for '%s' was not created yet!.\n", "isl_network");
         assert(false);
         exit(EXIT_FAILURE);
     }
-    info->offset_vertices = buffer_lines.size();
-
-    Object isl_network;
-    for (uint32_t i = 0; i < problem_instance.islCount(); i++) {
-        const InterSatelliteLink& edge = problem_instance.getISLs().at(i);
-        glm::vec3 sat1 = edge.getV1().cartesian_coordinates(sim_time) / real_world_scale;
-        glm::vec3 sat2 = edge.getV2().cartesian_coordinates(sim_time) / real_world_scale;
+    LineBatch isl_network(buffer_lines);
+    info->offset_vertices = isl_network.offset();
+
+    for (uint32_t i = 0; i < problem_instance->islCount(); i++) {
+        const InterSatelliteLink& edge = problem_instance->getISLs().at(i);
+        const glm::vec3& sat1_km = satellite_positions[edge.getV1Idx()];
+        const glm::vec3& sat2_km = satellite_positions[edge.getV2Idx()];
+        glm::vec3 sat1 = sat1_km / real_world_scale;
+        glm::vec3 sat2 = sat2_km / real_world_scale;
         glm::vec4 color = glm::vec4(1.f);
+        if (culling_enabled && culling.isCulled(sat1, sat2)) {
+            continue;
+        }
 
-        auto result = animation.getISLAnimation(i, sim_time);
-        if (result.first) {
-            if (!result.second.visible)
+        const AnimationDetails* details = compiled_animation.getISLAnimation(i);
+        if (details != nullptr) {
+            if (!details->visible)
                 continue; // this isl has to be invisible rn
-            color = result.second.color;
+            color = details->color;
         } else {
-            if (edge.isBlocked(sim_time)) { // edge can not be scanned
+            if (edge.isBlocked(sat1_km, sat2_km)) { // edge can not be scanned
                 color = glm::vec4(1.0f, 0.0f, 0.0f, 1.f);
             } else { // edge can be scanned
                 color = glm::vec4(0.0f, 1.0f, 0.0f, 1.f);
             }
         }
 
-        Object edge_line = OpenGLPrimitives::createLine(sat1, sat2, color);
-        isl_network.add(edge_line);
+        isl_network.add(sat1, sat2, color);
     }
 
     info->number_vertices = isl_network.vertexCount();
-    buffer_lines.values.insert(buffer_lines.values.end(), isl_network.vertices.begin(), isl_network.vertices.end());
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::recalculateGPUAnimation() {
+    // the shaders only need the time, the orbital elements are already on the GPU
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, orbit_elements_texture);
+    glProgramUniform1f(satellite_orbit_prog, glGetUniformLocation(satellite_orbit_prog, "sim_time"), sim_time);
+    glProgramUniform1f(isl_prog, glGetUniformLocation(isl_prog, "sim_time"), sim_time);
+    setSatelliteInstances(0, problem_instance->satelliteCount()); // gl_InstanceID is the index of the satellite
+
+    // satellite colors: r = -1 default color, r = -2 hidden
+    auto satellite_color = [this](const size_t i) {
+        const AnimationDetails* details = compiled_animation.getSatelliteAnimation(i);
+        if (details == nullptr) {
+            return glm::vec3(-1.f);
+        }
+        return details->visible ? glm::vec3(details->color) : glm::vec3(-2.f);
+    };
+
+    // ISL colors: a = -1 line of sight, a = -2 hidden
+    auto isl_color = [this](const size_t i) {
+        const AnimationDetails* details = compiled_animation.getISLAnimation(i);
+        if (details == nullptr) {
+            return glm::vec4(0.f, 0.f, 0.f, -1.f);
+        }
+        return details->visible ? details->color : glm::vec4(0.f, 0.f, 0.f, -2.f);
+    };
+
+    // the colors are not updated while the CPU calculates the orbits
+    if (gpu_colors_outdated) {
+        for (size_t i = 0; i < buffer_orbit_color.size(); i++) {
+            buffer_orbit_color.values[i] = satellite_color(i);
+        }
+        for (size_t i = 0; 2 * i < buffer_isl_color.size(); i++) {
+            buffer_isl_color.values[2 * i] = buffer_isl_color.values[2 * i + 1] = isl_color(i);
+        }
+        buffer_orbit_color.updateGPU();
+        buffer_isl_color.updateGPU();
+        profiler.countUpload(buffer_orbit_color.byte_size() + buffer_isl_color.byte_size());
+        gpu_colors_outdated = false;
+        return;
+    }
+
+    // otherwise only the animations that changed since the last frame are uploaded (as one range per buffer)
+    const std::vector<uint32_t>& satellites = compiled_animation.changedSatellites();
+    if (!satellites.empty()) {
+        size_t first = buffer_orbit_color.size(), last = 0;
+        for (uint32_t i : satellites) {
+            buffer_orbit_color.values[i] = satellite_color(i);
+            first = std::min<size_t>(first, i);
+            last = std::max<size_t>(last, i);
+        }
+        buffer_orbit_color.updateGPU(first, last - first + 1);
+        profiler.countUpload((last - first + 1) * sizeof(glm::vec3));
+    }
+
+    const std::vector<uint32_t>& isls = compiled_animation.changedISLs();
+    if (!isls.empty()) {
+        size_t first = buffer_isl_color.size(), last = 0;
+        for (uint32_t i : isls) {
+            buffer_isl_color.values[2 * i] = buffer_isl_color.values[2 * i + 1] = isl_color(i);
+            first = std::min<size_t>(first, 2 * i);
+            last = std::max<size_t>(last, 2 * i + 1);
+        }
+        buffer_isl_color.updateGPU(first, last - first + 1);
+        profiler.countUpload((last - first + 1) * sizeof(glm::vec4));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::applyOrbitMode() {
+    ObjectInfo* satellites = getObjectInfo("satellites");
+    ObjectInfo* satellite_points = getObjectInfo("satellite_points");
+    ObjectInfo* isl_network = getObjectInfo("isl_network");
+    if (satellites == nullptr || satellite_points == nullptr || isl_network == nullptr) {
+        return;
+    }
+
+    if (gpu_orbits) {
+        gpu_colors_outdated = true;
+        satellites->gl_program = satellite_points->gl_program = satellite_orbit_prog;
+        satellites->gl_vao = satellite_points->gl_vao = vao_orbit_satellites;
+        isl_network->gl_program = isl_prog;
+        isl_network->gl_vao = vao_orbit_isl;
+        isl_network->offset_vertices = 0;
+        isl_network->number_vertices = buffer_isl_satellites.size();
+    } else {
+        satellites->gl_program = satellite_points->gl_program = satellite_prog;
+        satellites->gl_vao = satellite_points->gl_vao = vao_satellites;
+        isl_network->gl_program = basic_program;
+        isl_network->gl_vao = vao_lines;
+    }
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void OpenGLWidget::recalculateLines() {
     glm::mat4 scale = glm::inverse(glm::scale(glm::vec3(zoom))); // ignore zoom
-    buffer_lines.values.clear();
 
     // build ISL network
-    recalculateISLNetwork();
+    {
+        FrameProfiler::ScopedStage stage(profiler, FrameStage::ISL_NETWORK);
+        recalculateISLNetwork();
+    }
 
     // build scheduled communications
+    FrameProfiler::ScopedStage stage(profiler, FrameStage::LINES);
     auto info = getObjectInfo("scheduled_communications");
     if (info == nullptr) {
         printf("Object info for '%s' was not created yet!.\n", "scheduled_communications");
         assert(false);
         exit(EXIT_FAILURE);
     }
-    info->offset_vertices = buffer_lines.size();
-    Object scheduled_communications;
+    LineBatch scheduled_communications(buffer_lines);
+    info->offset_vertices = scheduled_communications.offset();
 
     auto info_arrowhead = getObjectInfo("communications_arrowhead");
     if (info_arrowhead != nullptr)
         info_arrowhead->base_instance = buffer_transformations.size();
-    for (const auto& c : problem_instance.scheduled_communications) {
-        glm::vec3 sat1 = problem_instance.getSatellites()[c.first].cartesian_coordinates(sim_time) / real_world_scale;
-        glm::vec3 sat2 = problem_instance.getSatellites()[c.second].cartesian_coordinates(sim_time) / real_world_scale;
-        Object communication_line = OpenGLPrimitives::createLine(sat1, sat2, glm::vec4(.55f, .1f, 1.f, 1.f), true);
-        scheduled_communications.add(communication_line);
+    for (const auto& c : problem_instance->scheduled_communications) {
+        glm::vec3 sat1 = satellite_positions[c.first] / real_world_scale;
+        glm::vec3 sat2 = satellite_positions[c.second] / real_world_scale;
+        scheduled_communications.add(sat1, sat2, glm::vec4(.55f, .1f, 1.f, 1.f), true);
 
         // model transformation for arrowhead
         glm::mat4 translation = glm::translate(glm::vec3(sat2));
@@ -707,12 +1092,10 @@ void OpenGLWidget::recalculateLines() {
         float angle = acos(normal.y);
         glm::mat4 rotation = glm::rotate(angle, axis);
 
-        buffer_transformations.values.push_back(translation * rotation * scale);
+        buffer_transformations.push_back(translation * rotation * scale);
     }
 
     info->number_vertices = scheduled_communications.vertexCount();
-    buffer_lines.values.insert(
-        buffer_lines.values.end(), scheduled_communications.vertices.begin(), scheduled_communications.vertices.end());
 
     // build satellite orientations
     info = getObjectInfo("orientation_lines");
@@ -721,117 +1104,187 @@ void OpenGLWidget::recalculateLines() {
         assert(false);
         exit(EXIT_FAILURE);
     }
-    info->offset_vertices = buffer_lines.size();
-    Object orientation_lines;
+    LineBatch orientation_lines(buffer_lines);
+    info->offset_vertices = orientation_lines.offset();
 
     info_arrowhead = getObjectInfo("orientation_arrowhead");
     if (info_arrowhead != nullptr)
         info_arrowhead->base_instance = buffer_transformations.size(); // offset
-    for (auto const& it : animation.satellite_orientations) {
-        const Satellite& satellite = problem_instance.getSatellites().at(it.first);
-        glm::vec3 position = satellite.cartesian_coordinates(sim_time) / real_world_scale;
-        TimelineEvent<OrientationDetails> last_orientation = it.second.previousEvent(sim_time, false);
-        TimelineEvent<OrientationDetails> next_orientation = it.second.prevailingEvent(sim_time, false);
-
-        if (!last_orientation.isValid()) {
-            last_orientation.t_begin = 0.f;
-            last_orientation.data.orientation = glm::vec3(0.f);
-        }
+    for (const OrientedSatellite& oriented : arrow_satellites) {
+        glm::vec3 position = satellite_positions[oriented.first] / real_world_scale;
+        glm::vec3 direction_vector = interpolateOrientation(oriented, nullptr) * 0.03f;
 
-        if (!next_orientation.isValid()) {
-            next_orientation.t_begin = 0.f;
-            next_orientation.data.orientation = glm::vec3(0.f);
-        }
-
-        float angle =
-            std::acos(glm::dot(last_orientation.data.orientation, next_orientation.data.orientation)); // [rad]
-        float dt = sim_time - last_orientation.t_begin;
-
-        glm::vec3 direction_vector = last_orientation.data.orientation;
-        direction_vector = glm::rotate(direction_vector,
-                                       std::min(angle, dt * satellite.getRotationSpeed()),
-                                       glm::cross(direction_vector, next_orientation.data.orientation)) *
-                           0.03f;
+        // model transformation for arrowhead
+        glm::vec3 rotation_axis = glm::vec3(direction_vector.z, 0.f, -direction_vector.x);
+        float rotation_angle = acos(glm::normalize(direction_vector).y);
+        glm::mat4 rotation = glm::rotate(rotation_angle, rotation_axis);
+        glm::mat4 translation = glm::translate(glm::vec3(position + direction_vector));
+        buffer_transformations.push_back(translation * scale * rotation);
 
-        // cones are used as antennas?
-        if (problem_instance.getSatellites()[it.first].getConeAngle() <= 0.f) {
-            // model transformation for arrowhead
-            glm::vec3 rotation_axis = glm::vec3(direction_vector.z, 0.f, -direction_vector.x);
-            float rotation_angle = acos(glm::normalize(direction_vector).y);
-            glm::mat4 rotation = glm::rotate(rotation_angle, rotation_axis);
-            glm::mat4 translation = glm::translate(glm::vec3(position + direction_vector));
-            buffer_transformations.values.push_back(translation * scale * rotation);
-
-            orientation_lines.add(OpenGLPrimitives::createLine(position, position + direction_vector, glm::vec4(1.0f)));
-        }
+        orientation_lines.add(position, position + direction_vector, glm::vec4(1.0f));
     }
 
+    info->number_vertices = orientation_lines.vertexCount();
+
     auto info_cones = getObjectInfo("orientation_cones");
     if (info_cones != nullptr)
         info_cones->base_instance = buffer_transformations.size(); // offset
-    for (auto const& it : animation.satellite_orientations) {
-        const Satellite& satellite = problem_instance.getSatellites().at(it.first);
-        glm::vec3 position = satellite.cartesian_coordinates(sim_time) / real_world_scale;
-        TimelineEvent<OrientationDetails> last_orientation = it.second.previousEvent(sim_time, false);
-        TimelineEvent<OrientationDetails> next_orientation = it.second.prevailingEvent(sim_time, false);
-
-        if (!last_orientation.isValid()) {
-            last_orientation.t_begin = 0.f;
-            last_orientation.data.orientation = glm::vec3(0.f);
-        }
+    for (const OrientedSatellite& oriented : cone_satellites) {
+        glm::vec3 position = satellite_positions[oriented.first] / real_world_scale;
+        float length = 0.f;
+        glm::vec3 direction_vector = interpolateOrientation(oriented, &length);
 
-        if (!next_orientation.isValid()) {
-            next_orientation.t_begin = 0.f;
-            next_orientation.data.orientation = glm::vec3(0.f);
-        }
+        float cone_angle = problem_instance->getSatellites()[oriented.first].getConeAngle();
+        float radius = length * tanf(cone_angle / 2.f);
 
-        float angle =
-            std::acos(glm::dot(last_orientation.data.orientation, next_orientation.data.orientation)); // [rad]
-        float dt = sim_time - last_orientation.t_begin;
+        glm::mat4 size = glm::scale(glm::vec3(radius, length, radius));
+        glm::mat4 translation_origin =
+            glm::translate(glm::vec3(0.f, -length / 2.f, 0.f)); // move origin of cone to (0,0,0)
+        glm::mat4 translation = glm::translate(glm::vec3(position));
 
-        glm::vec3 direction_vector = last_orientation.data.orientation;
-        // TODO what if the vectors are linearly dependent? Then the cross product will be 0!
-        direction_vector = glm::rotate(direction_vector,
-                                       std::min(angle, dt * satellite.getRotationSpeed()),
-                                       glm::cross(direction_vector, next_orientation.data.orientation));
+        glm::vec3 rotation_axis = glm::vec3(-direction_vector.z, 0.f, direction_vector.x);
+        float rotation_angle = acos(glm::normalize(-direction_vector).y);
+        glm::mat4 rotation = glm::rotate(rotation_angle, rotation_axis);
 
-        // cones are used as antennas?
-        if (problem_instance.getSatellites()[it.first].getConeAngle() > 0.f) {
-            float length = next_orientation.data.cone_length;
-            float cone_angle = problem_instance.getSatellites()[it.first].getConeAngle();
-            float radius = length * tanf(cone_angle / 2.f);
+        buffer_transformations.push_back(translation * rotation * translation_origin * size);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+glm::vec3 OpenGLWidget::interpolateOrientation(const OrientedSatellite& oriented, float* cone_length) {
+    const Satellite& satellite = problem_instance->getSatellites()[oriented.first];
+    TimelineCursor* cursor = &orientation_cursors[oriented.first];
+    TimelineEvent<OrientationDetails> last_orientation = oriented.second->previousEvent(sim_time, false, cursor);
+    TimelineEvent<OrientationDetails> next_orientation = oriented.second->prevailingEvent(sim_time, false, cursor);
+
+    if (!last_orientation.isValid()) {
+        last_orientation.t_begin = 0.f;
+        last_orientation.data.orientation = glm::vec3(0.f);
+    }
+
+    if (!next_orientation.isValid()) {
+        next_orientation.t_begin = 0.f;
+        next_orientation.data.orientation = glm::vec3(0.f);
+    }
 
-            glm::mat4 size = glm::scale(glm::vec3(radius, length, radius));
-            glm::mat4 translation_origin =
-                glm::translate(glm::vec3(0.f, -length / 2.f, 0.f)); // move origin of cone to (0,0,0)
-            glm::mat4 translation = glm::translate(glm::vec3(position));
+    if (cone_length != nullptr) {
+        *cone_length = next_orientation.data.cone_length;
+    }
+
+    float angle = std::acos(glm::dot(last_orientation.data.orientation, next_orientation.data.orientation)); // [rad]
+    float dt = sim_time - last_orientation.t_begin;
+
+    // TODO what if the vectors are linearly dependent? Then the cross product will be 0!
+    glm::vec3 direction_vector = last_orientation.data.orientation;
+    return glm::rotate(direction_vector,
+                       std::min(angle, dt * satellite.getRotationSpeed()),
+                       glm::cross(direction_vector, next_orientation.data.orientation));
+}
 
-            glm::vec3 rotation_axis = glm::vec3(-direction_vector.z, 0.f, direction_vector.x);
-            float rotation_angle = acos(glm::normalize(-direction_vector).y);
-            glm::mat4 rotation = glm::rotate(rotation_angle, rotation_axis);
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::prepareAnimation() {
+    compiled_animation = CompiledAnimation(animation, problem_instance->satelliteCount(), problem_instance->islCount());
+    gpu_colors_outdated = true;
 
-            buffer_transformations.values.push_back(translation * rotation * translation_origin * size);
+    arrow_satellites.clear();
+    cone_satellites.clear();
+    for (const auto& it : animation.satellite_orientations) {
+        // cones are used as antennas?
+        if (problem_instance->getSatellites().at(it.first).getConeAngle() > 0.f) {
+            cone_satellites.push_back(OrientedSatellite(it.first, &it.second));
+        } else {
+            arrow_satellites.push_back(OrientedSatellite(it.first, &it.second));
         }
     }
+}
 
-    info->number_vertices = orientation_lines.vertexCount();
-    buffer_lines.values.insert(
-        buffer_lines.values.end(), orientation_lines.vertices.begin(), orientation_lines.vertices.end());
+// ------------------------------------------------------------------------------------------------
+
+void OpenGLWidget::allocateStreamBuffers(const size_t instance_count, const size_t line_vertex_count) {
+    buffer_transformations.allocate(GL_ARRAY_BUFFER, instance_count, buffer_storage);
+    buffer_satellite_color.allocate(GL_ARRAY_BUFFER, instance_count, buffer_storage);
+    buffer_lines.allocate(GL_ARRAY_BUFFER, line_vertex_count, buffer_storage);
+
+    // the vertex arrays have to refer to the new buffers
+    for (GLuint vertex_array : {vao, vao_satellites}) {
+        glBindVertexArray(vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_transformations.id()); // object transformations
+        glEnableVertexAttribArray(4);
+        glEnableVertexAttribArray(5);
+        glEnableVertexAttribArray(6);
+        glEnableVertexAttribArray(7);
+        // maximum size for vertexAttr is 4. So we split the 4x4matrix into 4x vec4
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(0));
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 4));
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 8));
+        glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (void*)(sizeof(float) * 12));
+        glVertexAttribDivisor(4, 1); // update transformation attr. every 1 instance instead of every vertex
+        glVertexAttribDivisor(5, 1);
+        glVertexAttribDivisor(6, 1);
+        glVertexAttribDivisor(7, 1);
+    }
+
+    glBindVertexArray(vao_satellites);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_satellite_color.id()); // dynamic satellite color
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    glVertexAttribDivisor(8, 1);
 
-    buffer_lines.pushToGPU();
+    glBindVertexArray(vao_lines);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_lines.id());
+    glEnableVertexAttribArray(0); // vertices
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), 0);
+    glEnableVertexAttribArray(1); // colors (RGBA8, alpha is ignored like before)
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(LineVertex), (void*)(sizeof(GL_FLOAT) * 3));
+    glBindVertexArray(0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
-void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
+void OpenGLWidget::prepareInstance(std::shared_ptr<const PhysicalInstance> instance) {
     deleteInstance();
     state = INSTANCE;
-    problem_instance = instance; // copy so visualization does not depend on original instance
+    problem_instance = std::move(instance); // shared, the instance can't change anymore
+    propagator = ConstellationPropagator(problem_instance->getSatellites());
+    orbit_table = OrbitTable(problem_instance->getSatellites(), orbit_table_samples);
+
+    // upper bounds of the data of one frame (see recalculate): satellites, arrowheads of the communications and one
+    // orientation (arrowhead or cone) per satellite
+    size_t satellite_count = problem_instance->satelliteCount();
+    size_t communication_count = problem_instance->scheduled_communications.size();
+    allocateStreamBuffers(2 * satellite_count + communication_count,
+                          problem_instance->islCount() * OpenGLPrimitives::lineVertexCount() +
+                              communication_count * OpenGLPrimitives::lineVertexCount(true) +
+                              satellite_count * OpenGLPrimitives::lineVertexCount());
+
+    // static data of the GPU orbits
+    buffer_orbit_elements.values = propagator.packElements();
+    buffer_isl_satellites.values.clear();
+    for (const InterSatelliteLink& isl : problem_instance->getISLs()) {
+        buffer_isl_satellites.values.push_back(glm::uvec2(isl.getV1Idx(), isl.getV2Idx()));
+        buffer_isl_satellites.values.push_back(glm::uvec2(isl.getV2Idx(), isl.getV1Idx()));
+    }
+    buffer_orbit_color.values.assign(problem_instance->satelliteCount(), glm::vec3(-1.f));
+    buffer_isl_color.values.assign(buffer_isl_satellites.size(), glm::vec4(0.f, 0.f, 0.f, -1.f));
+    buffer_orbit_elements.pushToGPU();
+    buffer_isl_satellites.pushToGPU();
+    buffer_orbit_color.pushToGPU();
+    buffer_isl_color.pushToGPU();
+    glBindTexture(GL_TEXTURE_BUFFER, orbit_elements_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer_orbit_elements.buffer_idx);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glProgramUniform1f(isl_prog,
+                       glGetUniformLocation(isl_prog, "radius_central_mass"),
+                       problem_instance->getRadiusCentralMass());
+
+    orientation_cursors.assign(problem_instance->satelliteCount(), TimelineCursor());
     std::vector<Object> objects;
 
     // central mass
-    Object sphere =
-        OpenGLPrimitives::createSphere(problem_instance.getRadiusCentralMass() / real_world_scale, glm::vec3(0.0f), 35);
+    Object sphere = OpenGLPrimitives::createSphere(problem_instance->getRadiusCentralMass() / real_world_scale,
+                                                   glm::vec3(0.0f), 35);
     sphere.name = "central_mass";
     sphere.gl_program = earth_prog;
     sphere.gl_vao = vao_satellites;
@@ -843,7 +1296,9 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
     all_orbits.name = "orbit";
     all_orbits.gl_program = basic_program;
     all_orbits.gl_vao = vao;
-    for (const Satellite& o : problem_instance.getSatellites()) {
+    std::vector<GLuint> coarse_orbits; // every COARSE_ORBIT_STEP-th vertex, appended to the detailed orbits
+    max_orbit_radius = 0.f;
+    for (const Satellite& o : problem_instance->getSatellites()) {
         // Orbit
         Object orbit = OpenGLPrimitives::createOrbit(o, real_world_scale, glm::vec3(0.0f));
         size_t offset = all_orbits.vertices.size(); // index 0 in orbit object has to refer the correct vertex
@@ -851,10 +1306,21 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
         all_orbits.elements.reserve(all_orbits.elements.capacity() + orbit.elements.size());
         all_orbits.elements.push_back(MAX_ELEMENT_ID); // restart GL_LINE_LOOP
 
+        coarse_orbits.push_back(MAX_ELEMENT_ID);
+
         for (const auto& i : orbit.elements) {
             all_orbits.elements.push_back(i + static_cast<GLuint>(offset));
+            if (i % COARSE_ORBIT_STEP == 0) {
+                coarse_orbits.push_back(i + static_cast<GLuint>(offset));
+            }
+        }
+        for (const VertexData& v : orbit.vertices) {
+            max_orbit_radius = std::max(max_orbit_radius, glm::length(v.position));
         }
     }
+    orbit_elements[0] = all_orbits.elements.size();
+    orbit_elements[1] = coarse_orbits.size();
+    all_orbits.elements.insert(all_orbits.elements.end(), coarse_orbits.begin(), coarse_orbits.end());
     objects.push_back(all_orbits);
 
     // Satellites
@@ -865,9 +1331,24 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
     satellites.gl_element_type = GL_UNSIGNED_BYTE;
     satellites.drawInstanced = true;
     // for each satellite in instance we need one copy of the satellite object
-    satellites.instance_count = problem_instance.getSatellites().size();
+    satellites.instance_count = problem_instance->getSatellites().size();
     objects.push_back(satellites);
 
+    // satellites that are smaller than a pixel are drawn as points (see updateLevelOfDetail)
+    Object satellite_points;
+    VertexData point = satellites.vertices[0];
+    point.position = glm::vec3(0.f);
+    satellite_points.vertices.push_back(point);
+    satellite_points.elements.push_back(0);
+    satellite_points.name = "satellite_points";
+    satellite_points.gl_draw_mode = GL_POINTS;
+    satellite_points.gl_program = satellite_prog;
+    satellite_points.gl_vao = vao_satellites;
+    satellite_points.gl_element_type = GL_UNSIGNED_BYTE;
+    satellite_points.drawInstanced = true;
+    satellite_points.instance_count = 0;
+    objects.push_back(satellite_points);
+
     // Edges & orientations
     Object line_obj;
     line_obj.gl_draw_mode = GL_LINES;
@@ -887,7 +1368,7 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
     cone.gl_vao = vao_satellites;
     cone.gl_element_type = GL_UNSIGNED_BYTE;
     cone.drawInstanced = true;
-    cone.instance_count = problem_instance.scheduled_communications.size();
+    cone.instance_count = problem_instance->scheduled_communications.size();
     objects.push_back(cone);
 
     // build arrowheads for satellite orientation (if cones are used)
@@ -908,7 +1389,7 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
     arrowhead_cone.drawInstanced = true;
     arrowhead_cone.instance_count = 0;
 
-    for (const auto& sat : problem_instance.getSatellites()) {
+    for (const auto& sat : problem_instance->getSatellites()) {
         if (sat.getConeAngle() > 0.f) {
             orientation_cone.instance_count++;
         } else {
@@ -923,6 +1404,11 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
     pushStaticSceneToGPU(objects);
     std::sort(scene.begin(), scene.end());
 
+    // the central mass hides large parts of the scene: drawing it first lets the depth test discard hidden fragments
+    // before they are shaded
+    std::stable_partition(
+        scene.begin(), scene.end(), [](const ObjectInfo& info) { return info.name == "central_mass"; });
+
     // build map to find objects by name
     for (int i = 0; i < scene.size(); i++) {
         const auto& obj = scene[i];
@@ -935,6 +1421,14 @@ void OpenGLWidget::prepareInstance(const PhysicalInstance& instance) {
             }
         }
     }
+
+    ObjectInfo* orbits = getObjectInfo("orbit");
+    if (orbits != nullptr) {
+        orbit_offset_elements = orbits->offset_elements;
+        orbits->number_elements = orbit_elements[0];
+    }
+
+    applyOrbitMode();
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -1052,6 +1546,9 @@ void OpenGLWidget::buildGUI() {
                 auto info = getObjectInfo("satellites");
                 if (info != nullptr)
                     info->enabled = !hide_satellites;
+                info = getObjectInfo("satellite_points");
+                if (info != nullptr)
+                    info->enabled = !hide_satellites;
             }
 
             static bool hide_earth = false;
@@ -1094,6 +1591,23 @@ void OpenGLWidget::buildGUI() {
                 if (info != nullptr)
                     info->enabled = !hide_orientations;
             }
+
+            if (ImGui::Checkbox("Calculate orbits on the GPU", &gpu_orbits)) {
+                applyOrbitMode();
+            }
+
+            ImGui::Checkbox("Skip hidden satellites and ISLs", &culling_enabled);
+
+            ImGui::Checkbox("Interpolate orbits", &use_orbit_table);
+            if (use_orbit_table && ImGui::InputInt("Samples per orbit", &orbit_table_samples, 16, 128,
+                                                   ImGuiInputTextFlags_EnterReturnsTrue)) {
+                orbit_table_samples = glm::clamp(orbit_table_samples, 4, 4096);
+                orbit_table = OrbitTable(problem_instance->getSatellites(), orbit_table_samples);
+            }
+        }
+
+        if (ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_None)) {
+            buildProfilerGUI();
         }
 
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
@@ -1105,6 +1619,40 @@ void OpenGLWidget::buildGUI() {
 
 // ------------------------------------------------------------------------------------------------
 
+void OpenGLWidget::buildProfilerGUI() {
+    const FrameProfiler::FrameCounts& counts = profiler.lastFrame();
+    ImGui::Text("%zu draw calls, %zu instances, %.1f KiB uploaded",
+                counts.draw_calls,
+                counts.instances,
+                counts.uploaded_bytes / 1024.f);
+
+    // one histogram per stage and clock, scaled to the largest time of the history
+    static bool show_gpu = true;
+    ImGui::Checkbox("GPU time (only scene and GUI)", &show_gpu);
+    for (size_t s = 0; s < FrameProfiler::STAGE_COUNT; s++) {
+        FrameStage stage = static_cast<FrameStage>(s);
+        const float* history = show_gpu ? profiler.gpuHistory(stage) : profiler.cpuHistory(stage);
+        if (show_gpu && stage != FrameStage::SCENE && stage != FrameStage::GUI) {
+            continue;
+        }
+
+        float mean = std::accumulate(history, history + FrameProfiler::HISTORY, 0.f) / FrameProfiler::HISTORY;
+        float max = *std::max_element(history, history + FrameProfiler::HISTORY);
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.3f ms (max %.3f ms)", mean, max);
+        ImGui::PlotHistogram(FrameProfiler::name(stage),
+                             history,
+                             FrameProfiler::HISTORY,
+                             profiler.historyOffset(),
+                             overlay,
+                             0.f,
+                             std::max(max, 1e-3f),
+                             ImVec2(0.f, 40.f));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
 void OpenGLWidget::destroy() {
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
@@ -1115,13 +1663,28 @@ void OpenGLWidget::destroy() {
     glDeleteProgram(basic_program);
     glDeleteProgram(satellite_prog);
     glDeleteProgram(earth_prog);
+    glDeleteProgram(shaded_prog);
+    glDeleteProgram(satellite_orbit_prog);
+    glDeleteProgram(isl_prog);
+    glDeleteTextures(1, &orbit_elements_texture);
     glDeleteTextures(1, &texture_id[0]);
     glDeleteTextures(1, &texture_id[1]);
     glDeleteVertexArrays(1, &vao);
     glDeleteVertexArrays(1, &vao_lines);
+    glDeleteVertexArrays(1, &vao_satellites);
+    glDeleteVertexArrays(1, &vao_orbit_satellites);
+    glDeleteVertexArrays(1, &vao_orbit_isl);
     glDeleteBuffers(1, &ibo_static);
     glDeleteBuffers(1, &vbo_static);
-    glDeleteBuffers(1, &vbo_uniforms);
+    for (GLsync& fence : frame_fences) {
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    buffer_uniforms.release();
+    buffer_transformations.release();
+    buffer_satellite_color.release();
+    buffer_lines.release();
+    profiler.release();
     glfwDestroyWindow(window);
     glfwTerminate();
 }
@@ -1132,6 +1695,13 @@ void OpenGLWidget::deleteInstance() {
     state = EMPTY;
     scene.clear();
     animation = Animation();
+    propagator = ConstellationPropagator();
+    orbit_table = OrbitTable();
+    satellite_positions.clear();
+    compiled_animation = CompiledAnimation();
+    orientation_cursors.clear();
+    arrow_satellites.clear();
+    cone_satellites.clear();
     object_names.clear();
     sim_speed = 1;
     sim_time = 0.f;
@@ -1,9 +1,12 @@
 #include "dmsc/animation.hpp"
 #include "dmsc/instance.hpp"
+#include "dmsc/propagator.hpp"
 #include "dmsc/solution_types.hpp"
 #include "dmsc/solver.hpp" // solution data type
+#include "dmsc/visuals.hpp" // RenderOptions
 #include "opengl_primitives.hpp"
 #include <map>
+#include <memory>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
@@ -17,41 +20,69 @@ namespace dmsc {
 
 constexpr auto PI2 = 2 * M_PI; // 2pi
 constexpr GLuint MAX_ELEMENT_ID = 4294967295;
+constexpr unsigned int COARSE_ORBIT_STEP = 5; // the coarse orbits use every n-th vertex (see updateLevelOfDetail)
 
 class OpenGLWidget {
   public:
-    OpenGLWidget();
+    /**
+     * @param offscreen If set, the window is hidden and the scene can only be rendered with record().
+     */
+    explicit OpenGLWidget(const bool offscreen = false);
     ~OpenGLWidget();
     OpenGLWidget(const OpenGLWidget&) = delete;
     OpenGLWidget& operator=(const OpenGLWidget&) = delete;
-    void show(const PhysicalInstance& instance, const Animation& animation, const float t0 = 0.f);
-    void show(const PhysicalInstance& instance, const float t0 = 0.f);
-    void show(const PhysicalInstance& instance, const DmscSolution& solution, const float t0 = 0.f);
-    void show(const PhysicalInstance& instance, const FreezeTagSolution& solution, const float t0 = 0.f);
+    void show(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation, const float t0 = 0.f);
+    void show(std::shared_ptr<const PhysicalInstance> instance, const float t0 = 0.f);
+    void show(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution, const float t0 = 0.f);
+    void show(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+              const float t0 = 0.f);
+
+    /**
+     * @brief Renders the animation frame by frame into an offscreen framebuffer and writes the frames as determined
+     * by the options. Returns after the last frame was written.
+     */
+    void record(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation,
+                const RenderOptions& options);
+    void record(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                const RenderOptions& options);
+    void record(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                const RenderOptions& options);
 
     enum VisualisationState { EMPTY, INSTANCE, SOLUTION };
 
   private:
-    void init();
+    using OrientedSatellite = std::pair<size_t, const Animation::OrientationTimeline*>; // (satellite, timeline)
+
+    void init(const bool offscreen);
     void destroy();
     void buildGUI();
+    void buildProfilerGUI();
     void renderScene();
     void recalculate();
     void recalculateOrbitPositions();
     void recalculateLines();
+    void prepareAnimation();
+    glm::vec3 interpolateOrientation(const OrientedSatellite& oriented, float* cone_length);
     void recalculateISLNetwork();
+    void recalculateGPUAnimation();
+    void updateLevelOfDetail(const float pixels_per_unit);
+    void setSatelliteInstances(const size_t base_instance, const size_t instance_count);
+    void applyOrbitMode();
+    void allocateStreamBuffers(const size_t instance_count, const size_t line_vertex_count); // upper bounds per frame
     void deleteInstance();
     void pushStaticSceneToGPU(const std::vector<OpenGLPrimitives::Object>& scene_objects);
     void loadTextures(const char* uniform_name, const char* file, GLuint& id);
     void openWindow();
+    void renderOffscreen(const RenderOptions& options);
     Animation animateScanCover(const PhysicalInstance& instance, const ScanCover& scan_cover);
+    Animation animateFreezeTag(const PhysicalInstance& instance, const FreezeTagSolution& solution);
     OpenGLPrimitives::ObjectInfo* getObjectInfo(const std::string& name);
 
     /**
      * @brief Convert a given instance with orbits and communications between the satellites into an opengl
      * scene.
      */
-    void prepareInstance(const PhysicalInstance& instance);
+    void prepareInstance(std::shared_ptr<const PhysicalInstance> instance);
 
     static void glfw_error_callback(int error, const char* description) {
         fprintf(stderr, "Glfw Error %d: %s\n", error, description);
@@ -59,17 +90,33 @@ class OpenGLWidget {
 
   private:
     GLFWwindow* window = nullptr;
+    bool offscreen = false; // hidden window, see record()
     const float real_world_scale = 7000.0f;
 
     // Handler
     GLuint basic_program = 0, satellite_prog = 0, earth_prog = 0, shaded_prog = 0;
-    GLuint vbo_static = 0u, ibo_static = 0u, vbo_uniforms = 0u;
+    GLuint satellite_orbit_prog = 0, isl_prog = 0; // evaluate the orbits in the shader (see gpu_orbits)
+    GLuint vbo_static = 0u, ibo_static = 0u;
     GLuint vao = 0u, vao_lines = 0u, vao_satellites = 0u;
-    OpenGLPrimitives::GLBuffer<glm::mat4> buffer_transformations;
-    OpenGLPrimitives::GLBuffer<glm::vec3> buffer_satellite_color;
-    OpenGLPrimitives::GLBuffer<OpenGLPrimitives::VertexData> buffer_lines;
+    GLuint vao_orbit_satellites = 0u, vao_orbit_isl = 0u;
     GLuint texture_id[2] = {0, 0};
 
+    // data of each frame: the builders write directly into the region of the current frame (see StreamStorage)
+    OpenGLPrimitives::StreamBuffer<glm::mat4> buffer_uniforms;
+    OpenGLPrimitives::StreamBuffer<glm::mat4> buffer_transformations;
+    OpenGLPrimitives::StreamBuffer<glm::vec3> buffer_satellite_color; // same capacity as the transformations
+    OpenGLPrimitives::StreamBuffer<OpenGLPrimitives::LineVertex> buffer_lines;
+    tools::BufferStorageProc buffer_storage = nullptr; // nullptr: no persistent mapping
+    GLsync frame_fences[OpenGLPrimitives::StreamStorage::REGIONS] = {}; // GPU finished the frame of a region
+    unsigned int frame_region = 0;
+
+    // static data of the GPU orbits: only the colors are uploaded again (and only if they changed)
+    OpenGLPrimitives::GLBuffer<glm::vec4> buffer_orbit_elements;  // see ConstellationPropagator::packElements
+    OpenGLPrimitives::GLBuffer<glm::uvec2> buffer_isl_satellites; // two vertices per ISL: (this end, other end)
+    OpenGLPrimitives::GLBuffer<glm::vec3> buffer_orbit_color;     // per satellite (see satellite_orbit.vert)
+    OpenGLPrimitives::GLBuffer<glm::vec4> buffer_isl_color;       // per vertex (see isl.vert)
+    GLuint orbit_elements_texture = 0u;
+
     // view and camera
     float zoom = 1.0f;
     glm::vec2 camera_rotation_angle_offset = glm::vec2(.0f, .0f);
@@ -84,11 +131,39 @@ class OpenGLWidget {
     std::map<std::string, size_t> object_names;
     std::vector<OpenGLPrimitives::ObjectInfo> scene;
     int state = VisualisationState::EMPTY;
-    PhysicalInstance problem_instance = PhysicalInstance();
+    std::shared_ptr<const PhysicalInstance> problem_instance = std::make_shared<const PhysicalInstance>();
     Animation animation = Animation();
+    ConstellationPropagator propagator;         // evaluates the positions of all satellites at once
+    OrbitTable orbit_table;                     // interpolates the positions instead (if use_orbit_table is set)
+    bool use_orbit_table = true;
+    bool gpu_orbits = false; // satellites and ISLs are positioned by the shaders
+    int orbit_table_samples = 128;              // per orbit
+    std::vector<glm::vec3> satellite_positions; // [km] positions of all satellites at sim_time
+
+    // culling and level of detail of the current frame
+    OpenGLPrimitives::ViewCulling culling;
+    bool culling_enabled = true;       // skip satellites and ISLs that are hidden or outside of the view
+    bool satellites_as_points = false; // the satellites are smaller than a pixel
+    size_t orbit_elements[2] = {0, 0}; // number of elements of the detailed and of the coarse orbits
+    size_t orbit_offset_elements = 0;  // [byte] beginning of the orbits in the element buffer
+    float max_orbit_radius = 0.f;      // largest distance of an orbit vertex from the origin
+
+    // satellite and ISL animations at sim_time, only changes since the last frame are applied (see prepareAnimation)
+    CompiledAnimation compiled_animation;
+    bool gpu_colors_outdated = true; // all colors of the GPU animation have to be rewritten (see applyOrbitMode)
+
+    // sim_time increases from frame to frame, so the orientation lookups continue where they stopped
+    std::vector<TimelineCursor> orientation_cursors;
+
+    // satellites with an orientation timeline (in animation), grouped once by their antenna (see prepareAnimation)
+    std::vector<OrientedSatellite> arrow_satellites; // orientation line with arrowhead
+    std::vector<OrientedSatellite> cone_satellites;  // cone of the antenna
     float sim_time = 0.0f;
     int sim_speed = 1;
     bool paused = false; // if true, the simulations is paused
+
+    // frame times of the stages, see the profiler in the GUI
+    tools::FrameProfiler profiler;
 };
 
 } // namespace dmsc
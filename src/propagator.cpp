@@ -0,0 +1,175 @@
+#include "dmsc/propagator.hpp"
+#include "dmsc/kepler.hpp"
+#include "fast_math.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace dmsc {
+
+ConstellationPropagator::ConstellationPropagator(const std::vector<Satellite>& satellites) {
+    size_t n = satellites.size();
+    radius.reserve(n);
+    initial_true_anomaly.reserve(n);
+    mean_angular_speed.reserve(n);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const Satellite& s = satellites[i];
+        float so = sinf(s.getArgumentPeriapsis()), co = cosf(s.getArgumentPeriapsis());
+        float sr = sinf(s.getRaan()), cr = cosf(s.getRaan());
+        float si = sinf(s.getInclination()), ci = cosf(s.getInclination());
+
+        // rotation of the orbital plane (see Satellite::cartesian_coordinates_angle) with the argument of periapsis
+        px.push_back(co * sr + so * ci * cr);
+        py.push_back(so * si);
+        pz.push_back(co * cr - so * ci * sr);
+        qx.push_back(-so * sr + co * ci * cr);
+        qy.push_back(co * si);
+        qz.push_back(-so * cr - co * ci * sr);
+
+        mean_angular_speed.push_back(s.getMeanAngularSpeed());
+        initial_true_anomaly.push_back(s.getTrueAnomaly());
+        radius.push_back(s.getSemiMajorAxis());
+        if (s.getEccentricity() != 0.f) {
+            float e = s.getEccentricity();
+            elliptical_idx.push_back(i);
+            eccentricity.push_back(e);
+            semi_minor_axis.push_back(s.getSemiMajorAxis() * std::sqrt(1.f - e * e));
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ConstellationPropagator::propagate(const float time, std::vector<glm::vec3>& positions) const {
+    positions.resize(size());
+    propagateCircular(time, positions.data(), 1);
+    propagateElliptical(time, positions.data(), 1);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ConstellationPropagator::propagate(const std::vector<float>& times, std::vector<glm::vec3>& positions) const {
+    size_t t_count = times.size();
+    positions.resize(size() * t_count);
+    for (size_t j = 0; j < t_count; j++) {
+        propagateCircular(times[j], positions.data() + j, t_count);
+        propagateElliptical(times[j], positions.data() + j, t_count);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+std::vector<glm::vec4> ConstellationPropagator::packElements() const {
+    size_t n = size();
+    std::vector<glm::vec4> elements(3 * n);
+    for (size_t i = 0; i < n; i++) {
+        // a circular orbit is an ellipse with e = 0 that starts at its initial true anomaly
+        elements[3 * i] = glm::vec4(radius[i], radius[i], 0.f, mean_angular_speed[i]);
+        elements[3 * i + 1] = glm::vec4(px[i], py[i], pz[i], initial_true_anomaly[i]);
+        elements[3 * i + 2] = glm::vec4(qx[i], qy[i], qz[i], 0.f);
+    }
+
+    // elliptical orbits start at the periapsis (see propagateElliptical)
+    for (size_t k = 0; k < elliptical_idx.size(); k++) {
+        uint32_t i = elliptical_idx[k];
+        elements[3 * i].y = semi_minor_axis[k];
+        elements[3 * i].z = eccentricity[k];
+        elements[3 * i + 1].w = 0.f;
+    }
+
+    return elements;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ConstellationPropagator::propagateCircular(const float time, glm::vec3* out, const size_t stride) const {
+    // elliptical orbits are calculated as well (to keep the loop free of branches) and overwritten afterwards
+    size_t n = size();
+    for (size_t i = 0; i < n; i++) {
+        float sin_v, cos_v;
+        tools::fastSinCos(initial_true_anomaly[i] + mean_angular_speed[i] * time, sin_v, cos_v);
+        glm::vec3& p = out[i * stride];
+        p.x = radius[i] * (cos_v * px[i] + sin_v * qx[i]);
+        p.y = radius[i] * (cos_v * py[i] + sin_v * qy[i]);
+        p.z = radius[i] * (cos_v * pz[i] + sin_v * qz[i]);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ConstellationPropagator::propagateElliptical(const float time, glm::vec3* out, const size_t stride) const {
+    // in blocks, so the temporary values fit on the stack
+    constexpr size_t BLOCK_SIZE = 64;
+    float mean_anomaly[BLOCK_SIZE];
+    float eccentric_anomaly[BLOCK_SIZE];
+
+    for (size_t begin = 0; begin < elliptical_idx.size(); begin += BLOCK_SIZE) {
+        size_t n = std::min(BLOCK_SIZE, elliptical_idx.size() - begin);
+        for (size_t k = 0; k < n; k++) {
+            mean_anomaly[k] = mean_angular_speed[elliptical_idx[begin + k]] * time;
+        }
+        eccentricAnomaly(n, mean_anomaly, &eccentricity[begin], eccentric_anomaly);
+
+        // position in the orbital plane: r * cos(true_anomaly) = a * (cos(E) - e), r * sin(true_anomaly) = b * sin(E)
+        for (size_t k = 0; k < n; k++) {
+            uint32_t i = elliptical_idx[begin + k];
+            float sin_e, cos_e;
+            tools::fastSinCos(eccentric_anomaly[k], sin_e, cos_e);
+            float u = radius[i] * (cos_e - eccentricity[begin + k]);
+            float v = semi_minor_axis[begin + k] * sin_e;
+            glm::vec3& p = out[i * stride];
+            p.x = u * px[i] + v * qx[i];
+            p.y = u * py[i] + v * qy[i];
+            p.z = u * pz[i] + v * qz[i];
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+OrbitTable::OrbitTable(const std::vector<Satellite>& satellites, const unsigned int samples_per_orbit)
+    : samples(std::max(samples_per_orbit, 4u)) {
+    size_t n = satellites.size();
+    size_t stride = samples + 3;
+    period.reserve(n);
+    sample_rate.reserve(n);
+    table.reserve(n * stride);
+
+    for (const Satellite& s : satellites) {
+        float p = s.getPeriod();
+        period.push_back(p);
+        sample_rate.push_back(samples / p);
+
+        // one sample before and two after the period, so the interpolation never has to wrap around
+        for (int k = -1; k <= static_cast<int>(samples) + 1; k++) {
+            table.push_back(s.cartesian_coordinates(p * k / samples));
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void OrbitTable::interpolate(const float time, std::vector<glm::vec3>& positions) const {
+    size_t n = size();
+    size_t stride = samples + 3;
+    positions.resize(n);
+
+    for (size_t i = 0; i < n; i++) {
+        // fmod is exact, so the sample position does not lose precision for large times
+        float phase = std::fmod(time, period[i]);
+        phase = phase < 0.f ? phase + period[i] : phase;
+        float u = phase * sample_rate[i];
+        unsigned int k = std::min(static_cast<unsigned int>(u), samples - 1);
+        float f = u - k;
+
+        // sample k is stored at k + 1
+        const glm::vec3* p = &table[i * stride + k];
+        glm::vec3 a = 2.f * p[1];
+        glm::vec3 b = p[2] - p[0];
+        glm::vec3 c = 2.f * p[0] - 5.f * p[1] + 4.f * p[2] - p[3];
+        glm::vec3 d = 3.f * (p[1] - p[2]) + p[3] - p[0];
+        positions[i] = 0.5f * (a + f * (b + f * (c + f * d)));
+    }
+}
+
+} // namespace dmsc
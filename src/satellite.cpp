@@ -1,4 +1,5 @@
 #include "dmsc/satellite.hpp"
+#include "dmsc/kepler.hpp"
 
 namespace dmsc {
 
@@ -16,6 +17,8 @@ Satellite::Satellite(const StateVector sv, const CentralMass& cm)
     semi_major_axis = (sv.height_perigee + cm.radius_central_mass) / (1 - sv.eccentricity);
     period = 2.0f * static_cast<float>(M_PI) * sqrtf(powf(semi_major_axis, 3.0f) / cm.gravitational_parameter); // [sec]
     mean_angular_speed = (2.0f * static_cast<float>(M_PI)) / period; // [rad/sec]
+    semi_latus_rectum = semi_major_axis - semi_major_axis * sv.eccentricity * sv.eccentricity;
+    anomaly_factor = std::sqrt((1 + sv.eccentricity) / (1 - sv.eccentricity));
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -27,20 +30,8 @@ glm::vec3 Satellite::cartesian_coordinates(const float time) const {
     if (sv.eccentricity == 0.0) { // circular orbit - easier to calculate
         current_true_anomaly = sv.initial_true_anomaly + mean_angular_speed * time;
     } else if (sv.eccentricity < 1.0f && sv.eccentricity > 0.0f) { // ellipse - numerical iteration needed
-        float mean_anomaly =
-            fmodf((2.0f * static_cast<float>(M_PI) / period) * time, 2.0f * static_cast<float>(M_PI)); // [rad]
-        float x = mean_anomaly;
-        float x_next;
-
-        for (int i = 0; i < 30; i++) {
-            x_next = x - ((x - sv.eccentricity * sinf(x) - mean_anomaly) / (1 - sv.eccentricity * cosf(x)));
-            if (fabsf(x_next - x) <= 0.00001f) {
-                break;
-            }
-            x = x_next;
-        }
-        current_true_anomaly =
-            2 * atanf(std::sqrt((1 + sv.eccentricity) / (1 - sv.eccentricity)) * tanf(x_next / 2.0f));
+        float eccentric_anomaly = eccentricAnomaly(mean_angular_speed * time, sv.eccentricity);
+        current_true_anomaly = 2 * atanf(anomaly_factor * tanf(eccentric_anomaly / 2.0f));
     }
 
     return cartesian_coordinates_angle(current_true_anomaly);
@@ -64,8 +55,7 @@ glm::vec3 Satellite::cartesian_coordinates_angle(const float true_anomaly) const
     if (sv.eccentricity == 0.f) {
         radius = semi_major_axis;
     } else {
-        radius = (semi_major_axis - semi_major_axis * sv.eccentricity * sv.eccentricity) /
-                 (1 + sv.eccentricity * cosf(true_anomaly));
+        radius = semi_latus_rectum / (1 + sv.eccentricity * cosf(true_anomaly));
     }
 
     // Equation 2.16 (MIS)
@@ -0,0 +1,276 @@
+#include "dmsc/scan_cover.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <utility>
+
+namespace dmsc {
+
+ScanCoverWriter::ScanCoverWriter(const std::string& file, const uint32_t chunk_size)
+    : file_name(file) {
+    header.chunk_size = std::max(chunk_size, 1u);
+    this->file = fopen(file.c_str(), "wb");
+    if (this->file == nullptr) {
+        printf("Scan cover %s could not be created.\n", file.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    // the number of scans is written by close()
+    fwrite(&header, sizeof(header), 1, this->file);
+    edges.reserve(header.chunk_size);
+    times.reserve(header.chunk_size);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCoverWriter::add(const uint32_t edge_idx, const float t) {
+    if (file == nullptr || (header.scan_count > 0 && t < last_time)) {
+        printf("The scan at t=%f can not be written to %s - the scans have to be in chronological order.\n", t,
+               file_name.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    edges.push_back(edge_idx);
+    times.push_back(t);
+    header.scan_count++;
+    last_time = t;
+    if (edges.size() == header.chunk_size) {
+        writeChunk();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCoverWriter::writeChunk() {
+    fwrite(edges.data(), sizeof(uint32_t), edges.size(), file);
+    fwrite(times.data(), sizeof(float), times.size(), file);
+    edges.clear();
+    times.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCoverWriter::close() {
+    if (file == nullptr) {
+        return;
+    }
+
+    writeChunk();
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    bool failed = ferror(file) != 0;
+    failed |= fclose(file) != 0;
+    file = nullptr;
+    if (failed) {
+        printf("Scan cover %s could not be written.\n", file_name.c_str());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+ScanCover::ScanCover(const ScanCover& other) { copyFrom(other); }
+
+// ------------------------------------------------------------------------------------------------
+
+ScanCover& ScanCover::operator=(const ScanCover& other) {
+    if (this != &other) {
+        finishSpill();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+ScanCover& ScanCover::operator=(ScanCover&& other) noexcept {
+    if (this != &other) {
+        finishSpill(); // the scans of this cover must not be lost
+        edges = std::move(other.edges);
+        times = std::move(other.times);
+        spill_file = std::move(other.spill_file);
+        writer = std::move(other.writer);
+        spill_chunk_size = other.spill_chunk_size;
+        spilled_count = other.spilled_count;
+        spilled_last_time = other.spilled_last_time;
+    }
+    return *this;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::copyFrom(const ScanCover& other) {
+    if (other.writer != nullptr) {
+        printf("The scan cover can not be copied while it is spilled to %s.\n", other.spill_file.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    edges = other.edges;
+    times = other.times;
+    spill_file = other.spill_file;
+    spill_chunk_size = other.spill_chunk_size;
+    spilled_count = other.spilled_count;
+    spilled_last_time = other.spilled_last_time;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::add(const uint32_t edge_idx, const float t) {
+    if (writer == nullptr && isSpilled()) {
+        printf("The scan at t=%f can not be added - the scans were spilled to %s, which is finished.\n", t,
+               spill_file.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+    if (writer != nullptr && scanCount() > 0 && t < lastTime()) {
+        printf("The scan at t=%f can not be spilled to %s - the scans have to be in chronological order.\n", t,
+               spill_file.c_str());
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+
+    if (times.empty() || times.back() <= t) {
+        edges.push_back(edge_idx);
+        times.push_back(t);
+    } else {
+        size_t pos = std::upper_bound(times.begin(), times.end(), t) - times.begin();
+        edges.insert(edges.begin() + pos, edge_idx);
+        times.insert(times.begin() + pos, t);
+    }
+
+    if (writer != nullptr && edges.size() >= spill_chunk_size) {
+        spillChunk();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::spill(const std::string& file, const uint32_t chunk_size) {
+    finishSpill();
+    spill_file = file;
+    spill_chunk_size = std::max(chunk_size, 1u);
+    spilled_count = 0;
+    writer = std::make_unique<ScanCoverWriter>(file, spill_chunk_size);
+    spillChunk();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::spillChunk() {
+    for (size_t i = 0; i < edges.size(); i++) {
+        writer->add(edges[i], times[i]);
+    }
+    spilled_count = writer->scanCount();
+    spilled_last_time = writer->lastTime();
+    edges.clear();
+    times.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::finishSpill() {
+    if (writer == nullptr) {
+        return;
+    }
+    spillChunk();
+    writer->close();
+    writer = nullptr;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::save(const std::string& file) const {
+    ScanCoverWriter writer(file);
+    for (size_t i = 0; i < edges.size(); i++) {
+        writer.add(edges[i], times[i]);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool ScanCover::load(const std::string& file) {
+    MappedScanCover mapped;
+    if (!mapped.open(file)) {
+        return false;
+    }
+
+    clear();
+    reserve(mapped.size());
+    for (size_t i = 0; i < mapped.size(); i++) {
+        edges.push_back(mapped.edgeIdx(i));
+        times.push_back(mapped.time(i));
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ScanCover::clear() {
+    finishSpill();
+    edges.clear();
+    times.clear();
+    spill_file.clear();
+    spill_chunk_size = 0;
+    spilled_count = 0;
+    spilled_last_time = 0.f;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+MappedScanCover::MappedScanCover()
+    : mapped_file(std::make_unique<tools::MappedFile>()) {}
+
+// ------------------------------------------------------------------------------------------------
+
+MappedScanCover::~MappedScanCover() = default;
+
+// ------------------------------------------------------------------------------------------------
+
+bool MappedScanCover::open(const std::string& file) {
+    close();
+    if (!mapped_file->open(file)) {
+        return false;
+    }
+
+    ScanCoverHeader expected;
+    ScanCoverHeader header;
+    if (mapped_file->size() < sizeof(ScanCoverHeader)) {
+        printf("The scan cover '%s' is invalid.\n", file.c_str());
+        close();
+        return false;
+    }
+    std::memcpy(&header, mapped_file->data(), sizeof(ScanCoverHeader));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version ||
+        header.chunk_size == 0) {
+        printf("The scan cover '%s' is invalid.\n", file.c_str());
+        close();
+        return false;
+    }
+    // compare the count before multiplying it, so a corrupt count can not wrap around
+    uint64_t max_count = (mapped_file->size() - sizeof(ScanCoverHeader)) / CHUNK_SCAN_SIZE;
+    if (header.scan_count > max_count ||
+        mapped_file->size() != sizeof(ScanCoverHeader) + CHUNK_SCAN_SIZE * header.scan_count) {
+        printf("The scan cover '%s' is incomplete.\n", file.c_str());
+        close();
+        return false;
+    }
+
+    scans = mapped_file->data() + sizeof(ScanCoverHeader);
+    chunk_size = header.chunk_size;
+    scan_count = header.scan_count;
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void MappedScanCover::close() {
+    mapped_file->close();
+    scans = nullptr;
+    chunk_size = 1;
+    scan_count = 0;
+}
+
+} // namespace dmsc
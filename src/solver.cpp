@@ -1,57 +1,85 @@
 #include "dmsc/solver.hpp"
 #include "dmsc/glm_include.hpp"
+#include "stats.hpp"
 #include <cmath>
+#include <cstdio>
 #include <ctime>
 #include <fstream>
 #include <random>
 
 namespace dmsc {
 
-float Solver::nextCommunication(const InterSatelliteLink& edge, const float time_0) {
+Solver::Solver(const PhysicalInstance& instance, const SolverOptions& options)
+    : Solver(std::make_shared<const PhysicalInstance>(instance), options) {}
+
+// ------------------------------------------------------------------------------------------------
+
+Solver::Solver(std::shared_ptr<const PhysicalInstance> instance, const SolverOptions& options)
+    : shared_instance(std::move(instance))
+    , instance(*shared_instance)
+    , options(options) {
+    tools::StatsRecording recording(StatTimer::SETUP);
+    visibility = std::make_shared<const VisibilityIndex>(this->instance, options.worker_count, options.cache_file,
+                                                         step_size);
+    resetOrientations();
+    setup_stats = recording.finish();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+Solver::Solver(std::shared_ptr<const PhysicalInstance> instance, std::shared_ptr<const VisibilityIndex> visibility,
+               const SolverOptions& options)
+    : shared_instance(std::move(instance))
+    , instance(*shared_instance)
+    , options(options)
+    , visibility(std::move(visibility)) {
+    if (!this->visibility || !this->visibility->matches(this->instance, step_size)) {
+        printf("The visibility index does not belong to the instance of this solver.\n");
+        assert(false);
+        exit(EXIT_FAILURE);
+    }
+    resetOrientations();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+float Solver::nextCommunication(const InterSatelliteLink& edge, const float time_0,
+                                const OrientationState& orientation) const {
+    DMSC_STATS_TIMER(NEXT_COMMUNICATION);
+
     // edge is never visible?
-    float t_visible = nextVisibility(edge, time_0);
-    if (t_visible >= INFINITY) {
+    size_t isl_idx = islIndex(edge);
+    if (visibility->getTimeSlots(isl_idx).size() == 0) {
         return INFINITY;
     }
 
     // get current orientation of both satellites
-    TimelineEvent<glm::vec3> sat1 = satellite_orientation[&edge.getV1()];
-    TimelineEvent<glm::vec3> sat2 = satellite_orientation[&edge.getV2()];
-
-    // edge can be scanned directly?
-    if (edge.canAlign(sat1, sat2, t_visible)) {
-        return t_visible;
-    }
+    const TimelineEvent<glm::vec3>& sat1 = orientation[edge.getV1Idx()];
+    const TimelineEvent<glm::vec3>& sat2 = orientation[edge.getV2Idx()];
 
-    // satellites can't align => search for a time where they can
     // max time to align ==> time for a 180 deg turn
     float t_max = std::max(static_cast<float>(M_PI) / edge.getV1().getRotationSpeed(),
                            static_cast<float>(M_PI) / edge.getV2().getRotationSpeed());
     t_max += edge.getPeriod();
 
-    for (float t = t_visible; t <= time_0 + t_max; t += step_size) {
-        if (edge.isBlocked(t)) { // skip time where edge is blocked
-            // find next slot where edge is visible
-            float t_relative = fmodf(t, edge.getPeriod());
-            auto search = edge_time_slots.find(&edge);
-            float t_next = 0.0f;
-
-            if (search != edge_time_slots.end()) {
-                t_next = search->second.nextTimeWithEvent(t_relative, true);
-            }
-
-            if (t_next < t_relative) { // loop applied
-                t += t_next + edge.getPeriod() - t_relative;
-            } else { // loop not applied
-                t += t_next - t_relative;
-            }
+    /* Only the beginnings of visibility windows and multiples of the step size are checked. Blocked times are skipped
+     * with the cached visibility windows and times where the satellites can't turn fast enough are skipped with a lower
+     * bound for the alignment. Since no valid candidate is skipped, the result is the first valid candidate after
+     * time_0 and doesn't change for any other start time in [time_0, result]. */
+    float t = nextCandidate(isl_idx, time_0);
+    while (t <= time_0 + t_max) {
+        DMSC_STATS_COUNT(NEXT_COMMUNICATION_STEPS, 1);
+        if (!visibility->isVisible(isl_idx, t)) { // jump to the next visibility window
+            t = std::max(visibility->nextWindowBegin(isl_idx, t), std::nextafter(t, INFINITY));
+            continue;
         }
 
-        if (edge.canAlign(sat1, sat2, t)) { // edge can be scanned
-            if (!edge.isBlocked(t)) {
-                return t;
-            }
+        if (!edge.isBlocked(t) && edge.canAlign(sat1, sat2, t)) { // edge can be scanned
+            return t;
         }
+
+        float t_align = edge.earliestAlignment(sat1, sat2, t);
+        t = nextCandidate(isl_idx, std::max(t_align, std::nextafter(t, INFINITY)));
     }
 
     // communication is never possible
@@ -60,67 +88,21 @@ float Solver::nextCommunication(const InterSatelliteLink& edge, const float time
 
 // ------------------------------------------------------------------------------------------------
 
-void Solver::createCache() {
-    for (const auto& edge : instance.getISLs()) {
-        for (float t = 0.0f; t < edge.getPeriod(); t += step_size) {
-            // TODO getPERIOD IS INFINIT if cm.gp = 0
-            float t_next = findNextVisiblity(edge, t);
-            if (t_next == INFINITY || t_next >= edge.getPeriod()) {
-                break;
-            }
-
-            float t_end = findLastVisible(edge, t_next);
-            if (t_end == INFINITY || t_end >= edge.getPeriod()) {
-                t_end = edge.getPeriod();
-            }
-
-            TimelineEvent<> slot(t_next, t_end);
-            edge_time_slots[&edge].insert(slot);
-            t = slot.t_end;
-        }
-    }
+float Solver::nextCandidate(const size_t isl_idx, const float t0) const {
+    float t_step = step_size * std::ceil(t0 / step_size);
+    return std::min(t_step, visibility->nextWindowBegin(isl_idx, t0));
 }
 
 // ------------------------------------------------------------------------------------------------
 
-float Solver::nextVisibility(const InterSatelliteLink& edge, const float t0) {
-    if (edge_time_slots[&edge].size() == 0) {
-        return INFINITY;
+size_t Solver::islIndex(const InterSatelliteLink& edge) const {
+    const std::vector<InterSatelliteLink>& edges = instance.getISLs();
+    if (edges.empty() || &edge < &edges.front() || &edge > &edges.back()) {
+        printf("The given ISL is not part of the instance of this solver.\n");
+        assert(false);
+        exit(EXIT_FAILURE);
     }
-
-    float t = std::fmod(t0, edge.getPeriod());
-    float n_periods = edge.getPeriod() * (int)(t0 / edge.getPeriod());
-
-    float t_next = edge_time_slots[&edge].nextTimeWithEvent(t, true);
-    if (t_next < t) { // loop applied
-        n_periods += edge.getPeriod();
-    }
-
-    return t_next + n_periods;
-}
-
-// ------------------------------------------------------------------------------------------------
-
-float Solver::findNextVisiblity(const InterSatelliteLink& edge, const float t0) const {
-    for (float t = t0; t <= t0 + edge.getPeriod(); t += step_size) {
-        if (!edge.isBlocked(t)) {
-            return t;
-        }
-    }
-    // edge is never visible
-    return INFINITY;
-}
-
-// ------------------------------------------------------------------------------------------------
-
-float Solver::findLastVisible(const InterSatelliteLink& edge, const float t0) const {
-    for (float t = t0; t <= t0 + edge.getPeriod(); t += step_size) {
-        if (edge.isBlocked(t)) {
-            return t - step_size;
-        }
-    }
-    // edge is never visible
-    return INFINITY;
+    return static_cast<size_t>(&edge - &edges.front());
 }
 
 } // namespace dmsc
@@ -1,4 +1,5 @@
 #include "dmsc/solver/greedy_next.hpp"
+#include "stats.hpp"
 #include <chrono>
 
 namespace dmsc {
@@ -8,12 +9,17 @@ namespace solver {
 // greedy next ignores the schedules communications - it scans all isl
 DmscSolution GreedyNext::solve() {
     // start time for computation time
-    auto t_start = std::chrono::system_clock::now();
+    auto t_start = std::chrono::steady_clock::now();
+    tools::StatsRecording recording(StatTimer::SOLVE, options.trace_file);
 
     // init variables
     ScanCover scan_cover;
+    if (!options.scan_cover_file.empty()) {
+        scan_cover.spill(options.scan_cover_file);
+    }
     float curr_time = 0.0;
-    satellite_orientation.clear();
+    bool cancelled = false;
+    resetOrientations();
 
     // select edges for computation
     std::vector<const InterSatelliteLink*> remaining_edges;
@@ -26,6 +32,10 @@ DmscSolution GreedyNext::solve() {
 
     // choose the best edge in each iteration.
     while (remaining_edges.size() > 0) {
+        if (isCancelled()) {
+            cancelled = true;
+            break;
+        }
         int best_edge_pos = 0;   // position in remaining edges
         float t_next = INFINITY; // absolute time
 
@@ -47,25 +57,27 @@ DmscSolution GreedyNext::solve() {
 
         // refresh orientation of chosen satellites.
         const InterSatelliteLink* e = remaining_edges.at(best_edge_pos);
-        glm::vec3 new_orientations = e->getOrientation(t_next);
-        satellite_orientation[&e->getV1()] = TimelineEvent<glm::vec3>(t_next, t_next, new_orientations);
-        satellite_orientation[&e->getV2()] = TimelineEvent<glm::vec3>(t_next, t_next, -new_orientations);
+        satellite_orientation.orient(*e, t_next);
 
         // map position in remaining edges to position in all edges
         std::ptrdiff_t edge_index = remaining_edges[best_edge_pos] - &instance.getISLs()[0];
         // add edge
-        scan_cover.insert({static_cast<uint32_t>(edge_index), t_next});
+        scan_cover.add(static_cast<uint32_t>(edge_index), t_next);
         remaining_edges.erase(remaining_edges.begin() + best_edge_pos);
         curr_time = t_next;
     }
 
+    scan_cover.finishSpill();
+
     // end time for computation time
-    auto t_end = std::chrono::system_clock::now();
+    auto t_end = std::chrono::steady_clock::now();
     std::chrono::duration<float> diff = t_end - t_start;
 
     DmscSolution solution;
     solution.computation_time = diff.count();
-    solution.scan_cover = scan_cover;
+    solution.stats = recording.finish(setup_stats);
+    solution.scan_cover = std::move(scan_cover);
+    solution.cancelled = cancelled;
     return solution;
 }
 
@@ -1,7 +1,8 @@
 #include "dmsc/solver/greedy_next_khop.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
 #include <chrono>
 #include <deque>
-#include <set>
 
 namespace dmsc {
 namespace solver {
@@ -12,50 +13,101 @@ namespace solver {
  */
 struct GreedyNextKHop::Communication {
     ScheduledCommunication scheduled_communication = {~0u, ~0u};
-    AdjacencyList possible_paths = AdjacencyList(0, AdjacencyList::Item(~0u, ~0u));
+    std::vector<AdjacencyList::Entry> possible_paths; // all edges of all paths; see AdjacencyList::sortEntries
     uint32_t forward_idx = 0u; // index of current vertex for the forward direction (sat1 -> sat2)
+    std::vector<bool> visited; // vertices of the chosen path so far (the edges of all paths may contain cycles)
+
+    bool isVisited(const uint32_t vertex_idx) const { return visited[vertex_idx]; }
 };
 
 // ------------------------------------------------------------------------------------------------
 
 DmscSolution GreedyNextKHop::solve() {
     // start time for computation time
-    auto t_start = std::chrono::system_clock::now();
+    auto t_start = std::chrono::steady_clock::now();
+    tools::StatsRecording recording(StatTimer::SOLVE, options.trace_file);
 
     // init variables
     ScanCover scan_cover;
+    if (!options.scan_cover_file.empty()) {
+        scan_cover.spill(options.scan_cover_file);
+    }
     float curr_time = 0.0;
-    satellite_orientation.clear();
+    bool cancelled = false;
+    resetOrientations();
 
     // select edges for computation
     std::vector<Communication> remaining_communications;
     for (const ScheduledCommunication& c : instance.scheduled_communications) {
+        if (isCancelled()) {
+            cancelled = true;
+            break;
+        }
         Communication communication;
         auto paths = findPaths(c.first, c.second);
         if (paths.first) { // there is at least one path from a to b
             communication.scheduled_communication = c;
-            communication.possible_paths = paths.second;
+            communication.possible_paths = std::move(paths.second);
             communication.forward_idx = c.first;
+            communication.visited.assign(instance.satelliteCount(), false);
+            communication.visited[c.first] = true;
             remaining_communications.push_back(communication);
         }
     }
 
+    /* The orientations only change after an edge was chosen, so all communication times of an iteration can be
+     * calculated in parallel. The serial selection below then reads them instead of calculating them itself (which
+     * results in the same scan cover). */
+    tools::ThreadPool pool(options.worker_count);
+    std::vector<size_t> first_candidate;  // index of the first candidate of a remaining communication
+    std::vector<uint32_t> candidate_isls; // possible next edges of all remaining communications
+    std::vector<float> candidate_times;   // nextCommunication() of candidate_isls
+    const bool parallel = pool.workerCount() > 1;
+
     // choose the best edge in each iteration
-    while (remaining_communications.size() > 0) {
+    while (!cancelled && remaining_communications.size() > 0) {
+        if (isCancelled()) {
+            cancelled = true;
+            break;
+        }
         uint32_t chosen_communication = ~0u;
         uint32_t chosen_neighbour = ~0u;
+        uint32_t chosen_isl = ~0u;
         float t_next = INFINITY; // absolute time
 
+        if (parallel) {
+            first_candidate.clear();
+            candidate_isls.clear();
+            for (const Communication& com : remaining_communications) {
+                first_candidate.push_back(candidate_isls.size());
+                for (const auto& neighbour : AdjacencyList::findRow(com.possible_paths, com.forward_idx)) {
+                    if (!com.isVisited(neighbour.column)) {
+                        candidate_isls.push_back(neighbour.item.isl_idx);
+                    }
+                }
+            }
+            candidate_times.resize(candidate_isls.size());
+            pool.parallelFor(candidate_isls.size(), [&](const size_t i, const unsigned int) {
+                candidate_times[i] = nextCommunication(instance.getISLs()[candidate_isls[i]], curr_time);
+            });
+        }
+
         // find the best edge depending on the time passed
-        for (uint32_t i = 0; i < remaining_communications.size(); i++) {
+        // c: position of the communication when the candidates were collected (before communications were removed)
+        for (uint32_t i = 0, c = 0; i < remaining_communications.size(); i++, c++) {
             const Communication& com = remaining_communications[i];
 
-            std::map<uint32_t, AdjacencyList::Item> possible_neighbours = com.possible_paths[com.forward_idx];
+            AdjacencyList::Row possible_neighbours = AdjacencyList::findRow(com.possible_paths, com.forward_idx);
             // iterate over all possibilities to continue the currently chosen path
             bool path_possible = false; // is there at least one edge we can use? (will be visible in the future)
+            size_t candidate_idx = parallel ? first_candidate[c] : 0u;
             for (const auto& neighbour : possible_neighbours) {
-                const InterSatelliteLink& link = instance.getISLs()[neighbour.second.isl_idx];
-                float next_communication = nextCommunication(link, curr_time);
+                if (com.isVisited(neighbour.column)) {
+                    continue; // the path would contain a cycle
+                }
+                const InterSatelliteLink& link = instance.getISLs()[neighbour.item.isl_idx];
+                float next_communication =
+                    parallel ? candidate_times[candidate_idx++] : nextCommunication(link, curr_time);
 
                 // will the edge become visible on the future?
                 if (next_communication < INFINITY) {
@@ -65,7 +117,8 @@ DmscSolution GreedyNextKHop::solve() {
                 // edge is avaible earlier
                 if (next_communication < t_next) {
                     t_next = next_communication;
-                    chosen_neighbour = neighbour.first;
+                    chosen_neighbour = neighbour.column;
+                    chosen_isl = neighbour.item.isl_idx;
                     chosen_communication = i;
                 }
 
@@ -88,12 +141,13 @@ DmscSolution GreedyNextKHop::solve() {
 
         // update communication
         Communication& com = remaining_communications[chosen_communication];
-        uint32_t isl_idx = com.possible_paths[com.forward_idx][chosen_neighbour].isl_idx;
+        uint32_t isl_idx = chosen_isl;
         com.forward_idx = chosen_neighbour;
+        com.visited[chosen_neighbour] = true;
 
         // add edge to solution
         const InterSatelliteLink* isl = &instance.getISLs()[isl_idx];
-        scan_cover.insert({isl_idx, t_next});
+        scan_cover.add(isl_idx, t_next);
 
         // if chosen communication is done now, remove it
         if (com.forward_idx == com.scheduled_communication.second) {
@@ -101,81 +155,105 @@ DmscSolution GreedyNextKHop::solve() {
         }
 
         // update satellite orientations
-        glm::vec3 new_orientations = isl->getOrientation(t_next);
-        satellite_orientation[&isl->getV1()] = TimelineEvent<glm::vec3>(t_next, t_next, new_orientations);
-        satellite_orientation[&isl->getV2()] = TimelineEvent<glm::vec3>(t_next, t_next, -new_orientations);
+        satellite_orientation.orient(*isl, t_next);
 
         // update time
         curr_time = t_next;
     }
 
+    scan_cover.finishSpill();
+
     // end time for computation time
-    auto t_end = std::chrono::system_clock::now();
+    auto t_end = std::chrono::steady_clock::now();
     std::chrono::duration<float> diff = t_end - t_start;
 
     DmscSolution solution;
     solution.computation_time = diff.count();
-    solution.scan_cover = scan_cover;
+    solution.stats = recording.finish(setup_stats);
+    solution.scan_cover = std::move(scan_cover);
+    solution.cancelled = cancelled;
     return solution;
 }
 
 // ------------------------------------------------------------------------------------------------
 
-std::pair<bool, AdjacencyList> GreedyNextKHop::findPaths(const uint32_t origin_idx,
-                                                         const uint32_t destination_idx) const {
-    // store path in correct order and sorted (to be able to find already visited vertices)
-    using Subpath = std::pair<std::vector<uint32_t>, std::set<uint32_t>>;
-
-    AdjacencyList result(instance.satelliteCount(), AdjacencyList::Item(0u, ~0u));
+std::pair<bool, std::vector<AdjacencyList::Entry>> GreedyNextKHop::findPaths(const uint32_t origin_idx,
+                                                                             const uint32_t destination_idx) const {
+    DMSC_STATS_TIMER(FIND_PATHS);
     const AdjacencyList& global_adj = instance.getAdjacencyMatrix();
-    std::deque<Subpath> subpaths = {{{origin_idx}, {origin_idx}}};
-    bool path_found = false; // at least one path found?
-
-    while (subpaths.size() > 0) {
-        Subpath subpath = subpaths.front();
-        subpaths.pop_front();
-
-        // iterate over all neighbour vertices of the last vertex in current subpath
-        for (const auto& neighbour : global_adj[subpath.first.back()]) {
-            // vertex visited before?
-            if (subpath.second.find(neighbour.first) != subpath.second.end()) {
-                continue;
+    PathSearch search(global_adj, destination_idx, k + 3); // k=1 allows paths with up to 4 edges
+
+    search.visited[origin_idx] = true;
+    search.run(origin_idx);
+
+    AdjacencyList::sortEntries(search.result);
+    return {!search.result.empty(), std::move(search.result)};
+}
+
+// ------------------------------------------------------------------------------------------------
+
+GreedyNextKHop::PathSearch::PathSearch(const AdjacencyList& adj, const uint32_t destination_idx,
+                                       const uint32_t max_edges)
+    : adj(adj)
+    , destination_idx(destination_idx)
+    , max_edges(max_edges)
+    , distance(adj.rowCount(), max_edges + 1)
+    , visited(adj.rowCount(), false)
+    , entry_used(adj.entryCount(), false) {
+    // breadth-first search from the destination (the adjacency list contains both directions of an ISL)
+    std::deque<uint32_t> queue = {destination_idx};
+    distance[destination_idx] = 0u;
+    while (queue.size() > 0) {
+        uint32_t vertex = queue.front();
+        queue.pop_front();
+        if (distance[vertex] + 1 >= max_edges) { // neighbours can't be part of a path anyway
+            continue;
+        }
+
+        for (const AdjacencyList::Entry& neighbour : adj[vertex]) {
+            if (distance[neighbour.column] > max_edges) {
+                distance[neighbour.column] = distance[vertex] + 1;
+                queue.push_back(neighbour.column);
             }
+        }
+    }
+}
 
-            // path complete?
-            if (neighbour.first == destination_idx) {
-                // add path to the final adjacency matrix
-                path_found = true;
-                for (uint32_t i = 0; (i + 1) < subpath.first.size(); i++) {
-                    uint32_t from_idx = subpath.first[i];
-                    uint32_t to_idx = subpath.first[i + 1];
-                    auto edge_used = global_adj[from_idx].find(to_idx);
-
-                    if (edge_used != global_adj[from_idx].end()) {
-                        result.matrix[from_idx][to_idx] = edge_used->second;
-                    } else {
-                        printf("The adjacency list does not include an entry (%u, %u).\n", from_idx, to_idx);
-                        assert(false);
-                        exit(EXIT_FAILURE);
-                    }
+// ------------------------------------------------------------------------------------------------
+
+void GreedyNextKHop::PathSearch::run(const uint32_t vertex_idx) {
+    DMSC_STATS_COUNT(PATH_VERTICES, 1);
+    // iterate over all neighbour vertices of the last vertex in current subpath
+    for (const AdjacencyList::Entry& neighbour : adj[vertex_idx]) {
+        // vertex visited before?
+        if (visited[neighbour.column]) {
+            continue;
+        }
+
+        // path complete? => add all edges of the path to the result
+        if (neighbour.column == destination_idx) {
+            subpath.push_back(&neighbour);
+            for (const AdjacencyList::Entry* edge_used : subpath) {
+                if (!entry_used[adj.entryIndex(*edge_used)]) {
+                    entry_used[adj.entryIndex(*edge_used)] = true;
+                    result.push_back(*edge_used);
                 }
-                // add last edge (which was not part of the subpath before) to the final adjacency matrix;
-                result.matrix[subpath.first.back()][destination_idx] = neighbour.second;
-                continue;
             }
+            subpath.pop_back();
+            continue;
+        }
 
-            // can we go deeper?
-            // k is number of "extra" satellites - e.g. k=1 allows 3 edges (origin, hop, target)
-            if (!(subpath.first.size() > k + 2)) {
-                Subpath new_subpath = subpath;
-                new_subpath.first.push_back(neighbour.first); // add vertex to the path
-                new_subpath.second.insert(neighbour.first);   // mark vertex as visited
-                subpaths.push_back(new_subpath);
-            }
+        // can we go deeper? the destination must be reachable with the remaining edges
+        if (subpath.size() + 1 + distance[neighbour.column] > max_edges) {
+            continue;
         }
-    }
 
-    return {path_found, result};
+        visited[neighbour.column] = true;
+        subpath.push_back(&neighbour);
+        run(neighbour.column);
+        subpath.pop_back();
+        visited[neighbour.column] = false;
+    }
 }
 
 } // namespace solver
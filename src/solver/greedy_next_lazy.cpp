@@ -0,0 +1,207 @@
+#include "dmsc/solver/greedy_next_lazy.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <queue>
+
+namespace dmsc {
+namespace solver {
+
+struct GreedyNextLazy::EdgeState {
+    float t_communication = INFINITY; // result of nextCommunication(edge, t_evaluation)
+    float t_evaluation = 0.f;
+    uint32_t version = 0u; // queue entries with another version are outdated
+    bool remaining = false;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+struct GreedyNextLazy::QueueEntry {
+    float t;
+    uint32_t isl_idx;
+    uint32_t version;
+
+    // std::priority_queue is a max-heap; GreedyNext prefers the lower index for equal times
+    bool operator<(const QueueEntry& e) const { return t > e.t || (t == e.t && isl_idx > e.isl_idx); }
+};
+
+// ------------------------------------------------------------------------------------------------
+
+DmscSolution GreedyNextLazy::solve() {
+    // start time for computation time
+    auto t_start = std::chrono::steady_clock::now();
+    tools::StatsRecording recording(StatTimer::SOLVE, options.trace_file);
+
+    // init variables
+    ScanCover scan_cover;
+    if (!options.scan_cover_file.empty()) {
+        scan_cover.spill(options.scan_cover_file);
+    }
+    float curr_time = 0.0;
+    bool cancelled = false;
+    resetOrientations();
+
+    const std::vector<InterSatelliteLink>& edges = instance.getISLs();
+    std::vector<EdgeState> state(edges.size());
+    std::priority_queue<QueueEntry> candidates; // by communication time
+    std::priority_queue<QueueEntry> expiries;   // edges without a communication time, by evaluation time
+
+    // edges of each satellite (the adjacency list only stores one ISL per pair of satellites)
+    std::vector<std::vector<uint32_t>> incident_edges(instance.satelliteCount());
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        incident_edges[edges[i].getV1Idx()].push_back(i);
+        incident_edges[edges[i].getV2Idx()].push_back(i);
+    }
+
+    auto evaluate = [&](const uint32_t isl_idx, const float t) {
+        const InterSatelliteLink& edge = edges[isl_idx];
+        EdgeState& s = state[isl_idx];
+        s.t_communication = nextCommunication(edge, t);
+        s.t_evaluation = t;
+        s.version++;
+        candidates.push({s.t_communication, isl_idx, s.version});
+
+        /* As long as neither orientation changes, a found communication time stays the same until it is reached (see
+         * nextCommunication). Without a communication, the growing search horizon can change the result at any time. */
+        if (s.t_communication == INFINITY) {
+            expiries.push({t, isl_idx, s.version});
+        }
+    };
+
+    // select edges for computation
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        evaluate(i, 0.0f);
+        state[i].remaining = state[i].t_communication < INFINITY;
+    }
+    size_t remaining_count = std::count_if(state.begin(), state.end(), [](const EdgeState& s) { return s.remaining; });
+
+    // choose the best edge in each iteration
+    std::vector<QueueEntry> buffer;
+    auto is_valid = [&](const QueueEntry& e) {
+        return state[e.isl_idx].remaining && state[e.isl_idx].version == e.version;
+    };
+    while (remaining_count > 0) {
+        if (isCancelled()) {
+            cancelled = true;
+            break;
+        }
+
+        // recalculate all communication times that might have changed since their evaluation
+        buffer.clear();
+        while (!expiries.empty() && expiries.top().t <= curr_time) {
+            QueueEntry e = expiries.top();
+            expiries.pop();
+            if (!is_valid(e)) {
+                continue;
+            }
+
+            if (state[e.isl_idx].t_evaluation == curr_time) {
+                buffer.push_back(e); // up to date - check again at a later time
+            } else {
+                evaluate(e.isl_idx, curr_time);
+            }
+        }
+        for (const QueueEntry& e : buffer) {
+            expiries.push(e);
+        }
+
+        // drop outdated candidates
+        while (!is_valid(candidates.top())) {
+            candidates.pop();
+        }
+
+        // no edge can be scanned in the search horizon anymore
+        if (candidates.top().t == INFINITY) {
+            break;
+        }
+
+        /* GreedyNext iterates over the edges in order and stops at the first edge that can be scanned at the current
+         * time. If there is an edge with a smaller index that can be scanned even earlier (rounding errors), no early
+         * stop happens and the earliest edge is chosen. */
+        buffer.clear();
+        while (!candidates.empty() && (buffer.empty() || candidates.top().t <= curr_time)) {
+            QueueEntry e = candidates.top();
+            candidates.pop();
+            if (is_valid(e)) {
+                buffer.push_back(e);
+            }
+        }
+        auto first_edge = std::min_element(buffer.begin(), buffer.end(), [](const QueueEntry& l, const QueueEntry& r) {
+            return l.isl_idx < r.isl_idx;
+        });
+        QueueEntry chosen = first_edge->t == curr_time ? *first_edge : buffer.front();
+        for (const QueueEntry& e : buffer) {
+            if (e.isl_idx != chosen.isl_idx) {
+                candidates.push(e);
+            }
+        }
+        float t_next = chosen.t;
+
+        // refresh orientation of chosen satellites.
+        const InterSatelliteLink& e = edges[chosen.isl_idx];
+        satellite_orientation.orient(e, t_next);
+
+        // add edge
+        scan_cover.add(chosen.isl_idx, t_next);
+        state[chosen.isl_idx].remaining = false;
+        remaining_count--;
+        curr_time = t_next;
+
+        // edges with a changed orientation have to be recalculated
+        for (uint32_t satellite_idx : {e.getV1Idx(), e.getV2Idx()}) {
+            for (uint32_t isl_idx : incident_edges[satellite_idx]) {
+                if (state[isl_idx].remaining) {
+                    evaluate(isl_idx, curr_time);
+                }
+            }
+        }
+    }
+
+    /* No remaining edge can be scanned within the search horizon. GreedyNext still schedules them one after another -
+     * do the same (without queue) to get an identical scan cover. */
+    std::vector<uint32_t> remaining_edges;
+    for (uint32_t i = 0; !cancelled && i < edges.size(); i++) {
+        if (state[i].remaining) {
+            remaining_edges.push_back(i);
+        }
+    }
+    while (remaining_edges.size() > 0) {
+        if (isCancelled()) {
+            cancelled = true;
+            break;
+        }
+        int best_edge_pos = 0;
+        float t_next = INFINITY;
+        for (size_t i = 0; i < remaining_edges.size(); i++) {
+            float next_communication = nextCommunication(edges[remaining_edges[i]], curr_time);
+            if (next_communication < t_next) {
+                t_next = next_communication;
+                best_edge_pos = i;
+            }
+            if (t_next - curr_time == 0.f)
+                break;
+        }
+
+        const InterSatelliteLink& e = edges[remaining_edges[best_edge_pos]];
+        satellite_orientation.orient(e, t_next);
+        scan_cover.add(remaining_edges[best_edge_pos], t_next);
+        remaining_edges.erase(remaining_edges.begin() + best_edge_pos);
+        curr_time = t_next;
+    }
+
+    scan_cover.finishSpill();
+
+    // end time for computation time
+    auto t_end = std::chrono::steady_clock::now();
+    std::chrono::duration<float> diff = t_end - t_start;
+
+    DmscSolution solution;
+    solution.computation_time = diff.count();
+    solution.stats = recording.finish(setup_stats);
+    solution.scan_cover = std::move(scan_cover);
+    solution.cancelled = cancelled;
+    return solution;
+}
+
+} // namespace solver
+} // namespace dmsc
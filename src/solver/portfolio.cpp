@@ -0,0 +1,145 @@
+#include "dmsc/solver/portfolio.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace dmsc {
+namespace solver {
+
+namespace {
+
+/**
+ * @brief Sets the coverage of a run: the ISLs with at least one scan and the scheduled communications whose message
+ * reaches the target when it is passed on along the scans in time order (like the satellites of animateFreezeTag).
+ */
+void measureCoverage(const PhysicalInstance& instance, const ScanCover& scan_cover, Portfolio::Run& run) {
+    const std::vector<InterSatelliteLink>& isls = instance.getISLs();
+    std::vector<bool> scanned(isls.size(), false);
+    for (size_t i = 0; i < scan_cover.size(); i++) {
+        scanned[scan_cover.edgeIdx(i)] = true;
+    }
+    run.covered_isls = static_cast<size_t>(std::count(scanned.begin(), scanned.end(), true));
+
+    run.served_communications = 0;
+    std::vector<bool> has_message(instance.satelliteCount());
+    for (const ScheduledCommunication& communication : instance.scheduled_communications) {
+        std::fill(has_message.begin(), has_message.end(), false);
+        has_message[communication.first] = true;
+        for (size_t i = 0; i < scan_cover.size() && !has_message[communication.second]; i++) {
+            const InterSatelliteLink& isl = isls[scan_cover.edgeIdx(i)];
+            if (has_message[isl.getV1Idx()] || has_message[isl.getV2Idx()]) {
+                has_message[isl.getV1Idx()] = true;
+                has_message[isl.getV2Idx()] = true;
+            }
+        }
+        run.served_communications += has_message[communication.second] ? 1 : 0;
+    }
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+
+Portfolio::Portfolio(std::shared_ptr<const PhysicalInstance> instance, const SolverOptions& options)
+    : instance(std::move(instance)) {
+    visibility = std::make_shared<const VisibilityIndex>(*this->instance, options.worker_count, options.cache_file);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+Portfolio::Portfolio(std::shared_ptr<const PhysicalInstance> instance,
+                     std::shared_ptr<const VisibilityIndex> visibility)
+    : instance(std::move(instance))
+    , visibility(std::move(visibility)) {}
+
+// ------------------------------------------------------------------------------------------------
+
+Portfolio::Result Portfolio::solve(const PortfolioOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    auto t_start = Clock::now();
+
+    Result result;
+    result.runs.resize(solvers.size());
+    std::vector<DmscSolution> solutions(solvers.size());
+    SolverOptions solver_options = options.solver_options;
+    solver_options.cancel = &cancelled;
+    solver_options.scan_cover_file.clear(); // the solvers would write into the same file
+
+    // the budget is watched by a thread of its own, so the solvers only have to check the flag
+    std::mutex mutex;
+    std::condition_variable done_condition;
+    bool done = false;
+    std::thread watcher;
+    if (std::isfinite(options.time_budget)) {
+        auto budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(options.time_budget));
+        watcher = std::thread([&, deadline = t_start + budget]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!done_condition.wait_until(lock, deadline, [&]() { return done; })) {
+                cancelled.store(true);
+            }
+        });
+    }
+
+    // every task writes into its own run and solution
+    tools::ThreadPool pool(options.worker_count);
+    pool.parallelFor(solvers.size(), [&](const size_t i, const unsigned int) {
+        Run& run = result.runs[i];
+        run.name = solvers[i].name;
+        if (cancelled.load()) {
+            return; // skipped
+        }
+
+        auto t_begin = Clock::now();
+        DmscSolution solution = solvers[i].factory(instance, visibility, solver_options);
+        std::chrono::duration<float> wall_time = Clock::now() - t_begin;
+        run.wall_time = wall_time.count();
+        run.computation_time = solution.computation_time;
+        run.scanned_edges = solution.scan_cover.scanCount();
+        if (solution.cancelled) {
+            run.status = RunStatus::CANCELLED;
+            return;
+        }
+
+        solution.scan_time = scanTime(solution.scan_cover);
+        run.status = RunStatus::COMPLETE;
+        run.scan_time = solution.scan_time;
+        measureCoverage(*instance, solution.scan_cover, run);
+        if (run.scan_time <= options.target_scan_time && run.isFullCoverage(*instance)) {
+            cancelled.store(true); // good enough - stop the others
+        }
+        solutions[i] = std::move(solution);
+    });
+
+    if (watcher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        done_condition.notify_all();
+        watcher.join();
+    }
+    // reset only after all solvers and the watcher stopped, a cancel() before solve() must not be lost
+    cancelled.store(false);
+
+    // best coverage and smallest scan time, ties are resolved by the order of the solvers (independent of the timing)
+    for (size_t i = 0; i < result.runs.size(); i++) {
+        const Run& run = result.runs[i];
+        if (run.status == RunStatus::COMPLETE &&
+            (result.best_idx == Result::NO_SOLUTION || run.isBetterThan(result.runs[result.best_idx]))) {
+            result.best_idx = i;
+        }
+    }
+    if (result.best_idx != Result::NO_SOLUTION) {
+        result.best = std::move(solutions[result.best_idx]);
+    }
+
+    std::chrono::duration<float> wall_time = Clock::now() - t_start;
+    result.wall_time = wall_time.count();
+    return result;
+}
+
+} // namespace solver
+} // namespace dmsc
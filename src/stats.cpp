@@ -0,0 +1,168 @@
+#include "stats.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace dmsc {
+
+SolverStats& SolverStats::operator+=(const SolverStats& other) {
+    collected |= other.collected;
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        counters[i] += other.counters[i];
+    }
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        timer_seconds[i] += other.timer_seconds[i];
+        timer_calls[i] += other.timer_calls[i];
+    }
+    return *this;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void SolverStats::print() const {
+    if (!collected) {
+        printf("No solver stats collected (build with DMSC_ENABLE_STATS).\n");
+        return;
+    }
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        printf("%-26s %16llu\n", name(static_cast<StatCounter>(i)), static_cast<unsigned long long>(counters[i]));
+    }
+    for (size_t i = 0; i < TIMER_COUNT; i++) {
+        printf("%-26s %12.3f sec %12llu calls\n", name(static_cast<StatTimer>(i)), timer_seconds[i],
+               static_cast<unsigned long long>(timer_calls[i]));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+const char* SolverStats::name(const StatCounter counter) {
+    switch (counter) {
+    case StatCounter::IS_BLOCKED:
+        return "is_blocked";
+    case StatCounter::KEPLER_ITERATIONS:
+        return "kepler_iterations";
+    case StatCounter::CAN_ALIGN:
+        return "can_align";
+    case StatCounter::NEXT_COMMUNICATION_STEPS:
+        return "next_communication_steps";
+    case StatCounter::PATH_VERTICES:
+        return "path_vertices";
+    default:
+        return "unknown";
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+const char* SolverStats::name(const StatTimer timer) {
+    switch (timer) {
+    case StatTimer::VISIBILITY_INDEX:
+        return "visibility_index";
+    case StatTimer::FIND_TIME_SLOTS:
+        return "find_time_slots";
+    case StatTimer::NEXT_COMMUNICATION:
+        return "next_communication";
+    case StatTimer::FIND_PATHS:
+        return "find_paths";
+    case StatTimer::SETUP:
+        return "setup";
+    case StatTimer::SOLVE:
+        return "solve";
+    default:
+        return "unknown";
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+namespace tools {
+
+thread_local ThreadStats* current_stats = nullptr;
+
+void ThreadStats::merge(const ThreadStats& other) {
+    stats += other.stats;
+    size_t free_events = trace.size() < MAX_TRACE_EVENTS ? MAX_TRACE_EVENTS - trace.size() : 0;
+    trace.insert(trace.end(), other.trace.begin(), other.trace.begin() + std::min(free_events, other.trace.size()));
+}
+
+// ------------------------------------------------------------------------------------------------
+
+ScopedTimer::~ScopedTimer() {
+    if (target == nullptr) {
+        return;
+    }
+    StatsClock::time_point end = StatsClock::now();
+    std::chrono::duration<double> duration = end - begin;
+    target->stats.add(timer, duration.count());
+
+    if (target->tracing && target->trace.size() < ThreadStats::MAX_TRACE_EVENTS) {
+        std::chrono::duration<double, std::micro> offset = begin - target->origin;
+        target->trace.push_back({timer, target->thread, offset.count(), duration.count() * 1e6});
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+StatsRecording::StatsRecording(const StatTimer timer, const std::string& trace_file)
+    : timer(timer)
+    , trace_file(trace_file) {
+#ifdef DMSC_ENABLE_STATS
+    stats.stats.collected = true;
+    stats.tracing = !trace_file.empty();
+    stats.origin = StatsClock::now();
+    previous = current_stats;
+    current_stats = &stats;
+    running = true;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+
+SolverStats StatsRecording::finish(const SolverStats& setup) {
+    stop();
+    SolverStats result = setup;
+    result += stats.stats;
+    return result;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void StatsRecording::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+
+    // the recording itself is measured as well
+    std::chrono::duration<double> duration = StatsClock::now() - stats.origin;
+    stats.stats.add(timer, duration.count());
+    if (stats.tracing) {
+        stats.trace.push_back({timer, 0u, 0., duration.count() * 1e6});
+    }
+    current_stats = previous;
+    if (stats.tracing) {
+        writeTrace();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void StatsRecording::writeTrace() const {
+    FILE* file = fopen(trace_file.c_str(), "w");
+    if (file == nullptr) {
+        printf("Could not open '%s' to write the trace.\n", trace_file.c_str());
+        return;
+    }
+
+    // complete events ("ph": "X") on one timeline per worker
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (size_t i = 0; i < stats.trace.size(); i++) {
+        const TraceEvent& event = stats.trace[i];
+        fprintf(file, "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                i == 0 ? "" : ",", SolverStats::name(event.timer), event.thread, event.begin, event.duration);
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+}
+
+} // namespace tools
+} // namespace dmsc
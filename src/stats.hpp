@@ -0,0 +1,145 @@
+#ifndef DMSC_STATS_H
+#define DMSC_STATS_H
+
+#include "dmsc/solver_stats.hpp"
+#include <chrono>
+#include <string>
+#include <vector>
+
+/* Instrumentation of the hot paths (see SolverStats). Without DMSC_ENABLE_STATS the macros expand to nothing, so the
+ * instrumented code is exactly the same as without them. */
+#ifdef DMSC_ENABLE_STATS
+#define DMSC_STATS_CONCAT_(a, b) a##b
+#define DMSC_STATS_CONCAT(a, b) DMSC_STATS_CONCAT_(a, b)
+#define DMSC_STATS_COUNT(counter, n) ::dmsc::tools::countStat(::dmsc::StatCounter::counter, n)
+#define DMSC_STATS_TIMER(timer)                                                                                        \
+    ::dmsc::tools::ScopedTimer DMSC_STATS_CONCAT(stats_timer_, __LINE__)(::dmsc::StatTimer::timer)
+#else
+#define DMSC_STATS_COUNT(counter, n) ((void)0)
+#define DMSC_STATS_TIMER(timer) ((void)0)
+#endif
+
+namespace dmsc {
+namespace tools {
+
+using StatsClock = std::chrono::steady_clock;
+
+struct TraceEvent {
+    StatTimer timer;
+    unsigned int thread; // worker index of the thread pool (0: thread that started the recording)
+    double begin;        // [us] since the beginning of the recording
+    double duration;     // [us]
+};
+
+/**
+ * @brief Stats of one thread. Only the owning thread writes into it, the thread pool merges them when its tasks are
+ * done.
+ */
+struct ThreadStats {
+    static constexpr size_t MAX_TRACE_EVENTS = 1u << 20; // per thread - later events are dropped
+
+    SolverStats stats;
+    std::vector<TraceEvent> trace;
+    bool tracing = false;
+    unsigned int thread = 0;
+    StatsClock::time_point origin; // beginning of the recording
+
+    /**
+     * @brief Adds the stats and trace events of another thread of the same recording.
+     */
+    void merge(const ThreadStats& other);
+};
+
+/**
+ * @brief Stats of the current thread; nullptr, if nothing is recorded (e.g. in the visualization).
+ */
+extern thread_local ThreadStats* current_stats;
+
+inline void countStat(const StatCounter counter, const uint64_t n) {
+    if (current_stats != nullptr) {
+        current_stats->stats.add(counter, n);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Sets the stats of the current thread until the scope ends.
+ */
+class StatsScope {
+  public:
+    explicit StatsScope(ThreadStats* stats)
+        : previous(current_stats) {
+        current_stats = stats;
+    }
+    ~StatsScope() { current_stats = previous; }
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+  private:
+    ThreadStats* previous;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Measures the time until the scope ends (see DMSC_STATS_TIMER).
+ */
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(const StatTimer timer)
+        : target(current_stats)
+        , timer(timer) {
+        if (target != nullptr) {
+            begin = StatsClock::now();
+        }
+    }
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+    ThreadStats* target;
+    StatTimer timer;
+    StatsClock::time_point begin;
+};
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Records the stats of the current thread and of the thread pools it starts until finish() is called.
+ * Recordings on different threads are independent of each other, so solvers can run concurrently.
+ */
+class StatsRecording {
+  public:
+    /**
+     * @param timer the whole recording is measured as this timer
+     * @param trace_file If set, all measured scopes are written to this file in the Chrome trace format (see
+     * chrome://tracing or https://ui.perfetto.dev).
+     */
+    explicit StatsRecording(const StatTimer timer, const std::string& trace_file = "");
+    ~StatsRecording() { stop(); }
+    StatsRecording(const StatsRecording&) = delete;
+    StatsRecording& operator=(const StatsRecording&) = delete;
+
+    /**
+     * @brief Stops the recording and writes the trace file.
+     * @param setup stats recorded before (e.g. while the solver was constructed) that are added to the result
+     */
+    SolverStats finish(const SolverStats& setup = SolverStats());
+
+  private:
+    void stop();
+    void writeTrace() const;
+
+    ThreadStats stats;
+    ThreadStats* previous = nullptr;
+    StatTimer timer;
+    std::string trace_file;
+    bool running = false;
+};
+
+} // namespace tools
+} // namespace dmsc
+
+#endif
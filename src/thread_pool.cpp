@@ -0,0 +1,131 @@
+#include "thread_pool.hpp"
+#include "stats.hpp"
+#include <algorithm>
+
+namespace dmsc {
+namespace tools {
+
+ThreadPool::ThreadPool(const unsigned int worker_count) {
+    unsigned int count = resolveWorkerCount(worker_count);
+    threads.reserve(count - 1);
+    for (unsigned int i = 1; i < count; i++) {
+        threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start_condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+unsigned int ThreadPool::resolveWorkerCount(const unsigned int worker_count) {
+    if (worker_count != 0) {
+        return worker_count;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ThreadPool::parallelFor(const size_t n, const std::function<void(const size_t, const unsigned int)>& task) {
+    if (n == 0) {
+        return;
+    }
+
+    // nothing to share
+    if (threads.empty() || n == 1) {
+        for (size_t i = 0; i < n; i++) {
+            task(i, 0u);
+        }
+        return;
+    }
+
+#ifdef DMSC_ENABLE_STATS
+    // every worker records into its own stats, they are added to the stats of the caller afterwards
+    ThreadStats* caller_stats = current_stats;
+    if (caller_stats != nullptr) {
+        std::vector<ThreadStats> worker_stats(workerCount());
+        for (unsigned int i = 0; i < worker_stats.size(); i++) {
+            worker_stats[i].tracing = caller_stats->tracing;
+            worker_stats[i].thread = i;
+            worker_stats[i].origin = caller_stats->origin;
+        }
+        run(n, [&](const size_t i, const unsigned int worker_idx) {
+            StatsScope scope(&worker_stats[worker_idx]);
+            task(i, worker_idx);
+        });
+        for (const ThreadStats& stats : worker_stats) {
+            caller_stats->merge(stats);
+        }
+        return;
+    }
+#endif
+
+    run(n, task);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ThreadPool::run(const size_t n, const std::function<void(const size_t, const unsigned int)>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        task_count = n;
+        next_task = 0;
+        busy_workers = static_cast<unsigned int>(threads.size());
+        generation++;
+    }
+    start_condition.notify_all();
+
+    process(0u);
+
+    // wait for the other workers - the task must stay alive until all of them are done
+    std::unique_lock<std::mutex> lock(mutex);
+    done_condition.wait(lock, [this] { return busy_workers == 0; });
+    current_task = nullptr;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ThreadPool::work(const unsigned int worker_idx) {
+    unsigned int seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_condition.wait(lock, [&] { return stop || generation != seen_generation; });
+            if (stop) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        process(worker_idx);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy_workers--;
+        }
+        done_condition.notify_one();
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void ThreadPool::process(const unsigned int worker_idx) {
+    for (size_t i = next_task++; i < task_count; i = next_task++) {
+        (*current_task)(i, worker_idx);
+    }
+}
+
+} // namespace tools
+} // namespace dmsc
@@ -0,0 +1,61 @@
+#ifndef DMSC_THREAD_POOL_H
+#define DMSC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dmsc {
+namespace tools {
+
+/**
+ * @brief Fixed number of worker threads that process indexed tasks. Workers fetch the next unprocessed index on their
+ * own, so expensive and cheap tasks are balanced automatically. The calling thread takes part in the processing.
+ */
+class ThreadPool {
+  public:
+    /**
+     * @param worker_count Number of threads (including the calling thread). 0 uses all hardware threads.
+     */
+    explicit ThreadPool(const unsigned int worker_count);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Calls task(i, worker_idx) for every i in [0, n) and blocks until all tasks are done. worker_idx is in
+     * [0, workerCount()) and unique for all tasks running concurrently - use it to access per-thread data.
+     */
+    void parallelFor(const size_t n, const std::function<void(const size_t, const unsigned int)>& task);
+
+    unsigned int workerCount() const { return static_cast<unsigned int>(threads.size()) + 1u; }
+
+    /**
+     * @brief Returns the given number of workers or the number of hardware threads, if 0 is given.
+     */
+    static unsigned int resolveWorkerCount(const unsigned int worker_count);
+
+  private:
+    void run(const size_t n, const std::function<void(const size_t, const unsigned int)>& task); // on all threads
+    void work(const unsigned int worker_idx);
+    void process(const unsigned int worker_idx);
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start_condition;
+    std::condition_variable done_condition;
+    const std::function<void(const size_t, const unsigned int)>* current_task = nullptr;
+    size_t task_count = 0;
+    std::atomic<size_t> next_task{0};
+    unsigned int busy_workers = 0;
+    unsigned int generation = 0; // incremented for every call of parallelFor
+    bool stop = false;
+};
+
+} // namespace tools
+} // namespace dmsc
+
+#endif
@@ -0,0 +1,354 @@
+#include "dmsc/visibility_index.hpp"
+#include "mapped_file.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <random>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dmsc {
+
+namespace {
+
+/**
+ * @brief Creates and opens a new file with a unique name next to the given file. No other process can open the same
+ * file, because it is created exclusively.
+ * @return nullptr, if no file could be created.
+ */
+FILE* createTemporaryFile(const std::string& file, std::string& tmp_file) {
+#ifdef _WIN32
+    std::random_device random;
+    for (int attempt = 0; attempt < 16; attempt++) {
+        tmp_file = file + ".tmp." + std::to_string(_getpid()) + "." + std::to_string(random());
+        int fd = _open(tmp_file.c_str(), _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd >= 0) {
+            FILE* fs = _fdopen(fd, "wb");
+            if (fs == nullptr) {
+                _close(fd);
+                std::remove(tmp_file.c_str());
+            }
+            return fs;
+        }
+    }
+    return nullptr;
+#else
+    std::string name = file + ".tmp.XXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        return nullptr;
+    }
+    tmp_file = name;
+    fchmod(fd, 0644); // mkstemp creates the file for the owner only
+    FILE* fs = fdopen(fd, "wb");
+    if (fs == nullptr) {
+        ::close(fd);
+        std::remove(tmp_file.c_str());
+    }
+    return fs;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Atomically replaces the given file (if it exists) by tmp_file. Processes that opened or mapped the old file
+ * keep reading the old content.
+ */
+bool replaceFile(const std::string& tmp_file, const std::string& file) {
+#ifdef _WIN32
+    return MoveFileExA(tmp_file.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tmp_file.c_str(), file.c_str()) == 0;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+
+/** Visibility cache file format (native byte order):
+ *
+ * CacheHeader
+ * uint64_t offsets[isl_count + 1]; // slots of ISL i: [offsets[i], offsets[i + 1])
+ * float slots[2 * slot_count];     // t_begin; t_end
+ */
+struct CacheHeader {
+    char magic[8] = {'D', 'M', 'S', 'C', 'V', 'I', 'S', '\0'};
+    uint32_t version = 1u;
+    uint32_t reserved = 0u;
+    uint64_t key = 0u; // see VisibilityIndex::cacheKey()
+    uint64_t isl_count = 0u;
+    uint64_t slot_count = 0u;
+};
+static_assert(sizeof(CacheHeader) == 40, "The cache header must not contain padding bytes.");
+
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief 64 bit FNV-1a hash.
+ */
+class Hash {
+  public:
+    template <typename T>
+    void add(const T& value) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    uint64_t value() const { return hash; }
+
+  private:
+    uint64_t hash = 14695981039346656037ull;
+};
+
+} // namespace
+
+VisibilityIndex::VisibilityIndex(const PhysicalInstance& instance, const unsigned int worker_count,
+                                 const std::string& cache_file, const float step_size)
+    : step_size(step_size)
+    , key(cacheKey(instance, step_size)) {
+    const std::vector<InterSatelliteLink>& edges = instance.getISLs();
+    periods.reserve(edges.size());
+    for (const InterSatelliteLink& edge : edges) {
+        periods.push_back(edge.getPeriod());
+    }
+
+    if (!cache_file.empty() && loadCache(cache_file)) {
+        return;
+    }
+
+    DMSC_STATS_TIMER(VISIBILITY_INDEX);
+    time_slots.assign(edges.size(), TimeSlots());
+
+    // the edges are independent of each other and every task writes into its own slot
+    tools::ThreadPool pool(worker_count);
+    pool.parallelFor(edges.size(),
+                     [&](const size_t i, const unsigned int) { time_slots[i] = findTimeSlots(edges[i]); });
+
+    if (!cache_file.empty()) {
+        saveCache(cache_file);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+uint64_t VisibilityIndex::cacheKey(const PhysicalInstance& instance, const float step_size) {
+    Hash hash;
+    hash.add(instance.getRadiusCentralMass());
+    for (const Satellite& s : instance.getSatellites()) {
+        // all parameters of the state vector
+        hash.add(s.getHeightPerigee());
+        hash.add(s.getEccentricity());
+        hash.add(s.getInclination());
+        hash.add(s.getArgumentPeriapsis());
+        hash.add(s.getRaan());
+        hash.add(s.getRotationSpeed());
+        hash.add(s.getTrueAnomaly());
+        hash.add(s.getConeAngle());
+        hash.add(s.getPeriod()); // depends on the gravitational parameter
+    }
+    for (const InterSatelliteLink& isl : instance.getISLs()) {
+        hash.add(isl.getV1Idx());
+        hash.add(isl.getV2Idx());
+    }
+    hash.add(step_size);
+    return hash.value();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool VisibilityIndex::loadCache(const std::string& file) {
+    tools::MappedFile mapped_file;
+    if (!mapped_file.open(file)) {
+        return false;
+    }
+
+    // check whether the file belongs to this instance
+    CacheHeader expected;
+    expected.key = key;
+    expected.isl_count = periods.size();
+
+    CacheHeader header;
+    if (mapped_file.size() < sizeof(CacheHeader)) {
+        printf("The visibility cache '%s' is invalid and will be rebuilt.\n", file.c_str());
+        return false;
+    }
+    std::memcpy(&header, mapped_file.data(), sizeof(CacheHeader));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version ||
+        header.key != expected.key || header.isl_count != expected.isl_count) {
+        printf("The visibility cache '%s' does not match the instance and will be rebuilt.\n", file.c_str());
+        return false;
+    }
+
+    // compare the counts before multiplying them, so a corrupt header can not wrap around
+    size_t remaining = mapped_file.size() - sizeof(CacheHeader); // [byte]
+    if (header.isl_count >= remaining / sizeof(uint64_t)) {
+        printf("The visibility cache '%s' is incomplete and will be rebuilt.\n", file.c_str());
+        return false;
+    }
+    size_t offsets_size = sizeof(uint64_t) * (header.isl_count + 1);
+    remaining -= offsets_size;
+    if (header.slot_count > remaining / (2 * sizeof(float))) {
+        printf("The visibility cache '%s' is incomplete and will be rebuilt.\n", file.c_str());
+        return false;
+    }
+    size_t slots_size = sizeof(float) * 2 * header.slot_count;
+    if (remaining != slots_size) {
+        printf("The visibility cache '%s' is incomplete and will be rebuilt.\n", file.c_str());
+        return false;
+    }
+
+    const char* offsets = mapped_file.data() + sizeof(CacheHeader);
+    const char* slots = offsets + offsets_size;
+    time_slots.assign(header.isl_count, TimeSlots());
+    for (size_t i = 0; i < header.isl_count; i++) {
+        uint64_t range[2];
+        std::memcpy(range, offsets + i * sizeof(uint64_t), sizeof(range));
+        if (range[0] > range[1] || range[1] > header.slot_count) {
+            printf("The visibility cache '%s' is invalid and will be rebuilt.\n", file.c_str());
+            return false;
+        }
+
+        // the slots are sorted, so every insert appends to the timeline
+        time_slots[i].reserve(range[1] - range[0]);
+        for (uint64_t j = range[0]; j < range[1]; j++) {
+            float slot[2];
+            std::memcpy(slot, slots + j * sizeof(slot), sizeof(slot));
+            if (!time_slots[i].insert(TimelineEvent<>(slot[0], slot[1]))) {
+                printf("The visibility cache '%s' is invalid and will be rebuilt.\n", file.c_str());
+                time_slots.clear();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void VisibilityIndex::saveCache(const std::string& file) const {
+    CacheHeader header;
+    header.key = key;
+    header.isl_count = time_slots.size();
+
+    std::vector<uint64_t> offsets = {0u};
+    std::vector<float> slots;
+    for (const TimeSlots& windows : time_slots) {
+        for (const TimelineEvent<>& slot : windows) {
+            slots.push_back(slot.t_begin);
+            slots.push_back(slot.t_end);
+        }
+        offsets.push_back(slots.size() / 2);
+    }
+    header.slot_count = slots.size() / 2;
+
+    // write into a temporary file of our own first, so other processes never read an incomplete cache
+    std::string tmp_file;
+    FILE* fs = createTemporaryFile(file, tmp_file);
+    if (fs == nullptr) {
+        printf("Visibility cache %s could not be created.\n", file.c_str());
+        return;
+    }
+    fwrite(&header, sizeof(header), 1, fs);
+    fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), fs);
+    fwrite(slots.data(), sizeof(float), slots.size(), fs);
+    bool failed = ferror(fs) != 0;
+    failed |= fclose(fs) != 0;
+
+    if (failed || !replaceFile(tmp_file, file)) {
+        printf("Visibility cache %s could not be written.\n", file.c_str());
+        std::remove(tmp_file.c_str());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+VisibilityIndex::TimeSlots VisibilityIndex::findTimeSlots(const InterSatelliteLink& edge) const {
+    DMSC_STATS_TIMER(FIND_TIME_SLOTS);
+    TimeSlots windows;
+    for (float t = 0.0f; t < edge.getPeriod(); t += step_size) {
+        // TODO getPERIOD IS INFINIT if cm.gp = 0
+        float t_next = edge.nextVisible(t, t + edge.getPeriod(), step_size);
+        if (t_next == INFINITY || t_next >= edge.getPeriod()) {
+            break;
+        }
+
+        float t_end = edge.lastVisible(t_next, t_next + edge.getPeriod(), step_size);
+        if (t_end == INFINITY || t_end >= edge.getPeriod()) {
+            t_end = edge.getPeriod();
+        }
+
+        TimelineEvent<> slot(t_next, t_end);
+        windows.insert(slot);
+        t = slot.t_end;
+    }
+    return windows;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+float VisibilityIndex::nextVisibility(const size_t isl_idx, const float t0) const {
+    const TimeSlots& windows = time_slots[isl_idx];
+    if (windows.size() == 0) {
+        return INFINITY;
+    }
+
+    float t = std::fmod(t0, periods[isl_idx]);
+    float n_periods = periods[isl_idx] * (int)(t0 / periods[isl_idx]);
+
+    float t_next = windows.nextTimeWithEvent(t, true);
+    if (t_next < t) { // loop applied
+        n_periods += periods[isl_idx];
+    }
+
+    return t_next + n_periods;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+bool VisibilityIndex::isVisible(const size_t isl_idx, const float t) const {
+    float t_relative = std::fmod(t, periods[isl_idx]);
+    TimelineEvent<> slot = time_slots[isl_idx].prevailingEvent(t_relative);
+    return slot.isValid() && slot.t_begin <= t_relative;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+float VisibilityIndex::nextWindowBegin(const size_t isl_idx, const float t0) const {
+    const TimeSlots& windows = time_slots[isl_idx];
+    if (windows.size() == 0) {
+        return INFINITY;
+    }
+
+    // the same window always results in the same value, regardless of t0
+    float t = std::fmod(t0, periods[isl_idx]);
+    float n_periods = std::round((t0 - t) / periods[isl_idx]);
+
+    TimelineEvent<> slot = windows.prevailingEvent(t);
+    if (slot.isValid() && slot.t_begin < t) { // slot is already active
+        slot = windows.prevailingEvent(slot.t_end);
+    }
+    if (!slot.isValid()) { // loop applied
+        slot = windows.prevailingEvent(0.f);
+        n_periods += 1.f;
+    }
+
+    return slot.t_begin + periods[isl_idx] * n_periods;
+}
+
+} // namespace dmsc
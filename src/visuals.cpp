@@ -5,46 +5,105 @@
 
 namespace dmsc {
 
-void visualizeInstance(const Instance& instance, const float t0) { visualizeInstance(PhysicalInstance(instance), t0); }
+void visualizeInstance(const Instance& instance, const float t0) {
+    visualizeInstance(std::make_shared<const PhysicalInstance>(instance), t0);
+}
 
 // ------------------------------------------------------------------------------------------------
 
 void visualizeInstance(const PhysicalInstance& instance, const float t0) {
+    visualizeInstance(std::make_shared<const PhysicalInstance>(instance), t0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void visualizeInstance(std::shared_ptr<const PhysicalInstance> instance, const float t0) {
     OpenGLWidget gl;
-    gl.show(instance, t0);
+    gl.show(std::move(instance), t0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void visualizeDmscSolution(const Instance& instance, const DmscSolution& solution, const float t0) {
-    visualizeDmscSolution(PhysicalInstance(instance), solution, t0);
+    visualizeDmscSolution(std::make_shared<const PhysicalInstance>(instance), solution, t0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void visualizeDmscSolution(const PhysicalInstance& instance, const DmscSolution& solution, const float t0) {
+    visualizeDmscSolution(std::make_shared<const PhysicalInstance>(instance), solution, t0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void visualizeDmscSolution(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                           const float t0) {
     OpenGLWidget gl;
-    gl.show(instance, solution, t0);
+    gl.show(std::move(instance), solution, t0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void visualizeCustom(const Instance& instance, const Animation& animation, const float t0) {
-    visualizeCustom(PhysicalInstance(instance), animation, t0);
+    visualizeCustom(std::make_shared<const PhysicalInstance>(instance), animation, t0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void visualizeCustom(const PhysicalInstance& instance, const Animation& animation, const float t0) {
+    visualizeCustom(std::make_shared<const PhysicalInstance>(instance), animation, t0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void visualizeCustom(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation, const float t0) {
     OpenGLWidget gl;
-    gl.show(instance, animation, t0);
+    gl.show(std::move(instance), animation, t0);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 void visualizeFreezeTagSolution(const PhysicalInstance& instance, const FreezeTagSolution& solution, const float t0) {
+    visualizeFreezeTagSolution(std::make_shared<const PhysicalInstance>(instance), solution, t0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void visualizeFreezeTagSolution(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                                const float t0) {
     OpenGLWidget gl;
-    gl.show(instance, solution, t0);
+    gl.show(std::move(instance), solution, t0);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void renderInstance(std::shared_ptr<const PhysicalInstance> instance, const RenderOptions& options) {
+    OpenGLWidget gl(true);
+    gl.record(std::move(instance), Animation(), options);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void renderDmscSolution(std::shared_ptr<const PhysicalInstance> instance, const DmscSolution& solution,
+                        const RenderOptions& options) {
+    OpenGLWidget gl(true);
+    gl.record(std::move(instance), solution, options);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void renderCustom(std::shared_ptr<const PhysicalInstance> instance, const Animation& animation,
+                  const RenderOptions& options) {
+    OpenGLWidget gl(true);
+    gl.record(std::move(instance), animation, options);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void renderFreezeTagSolution(std::shared_ptr<const PhysicalInstance> instance, const FreezeTagSolution& solution,
+                             const RenderOptions& options) {
+    OpenGLWidget gl(true);
+    gl.record(std::move(instance), solution, options);
 }
 
 } // namespace dmsc
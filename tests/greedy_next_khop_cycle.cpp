@@ -0,0 +1,84 @@
+#include "dmsc/solver/greedy_next_khop.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+//===================================
+// Regression test: the edges of all paths of a communication can contain both directions of an ISL. GreedyNextKHop
+// walked back and forth along such an ISL forever. All satellites share one circular orbit, so every ISL is either
+// always visible (at most 60 deg apart) or always blocked by the earth. A hang fails the test by its timeout.
+//
+// served:  0 -> 3 in the satellites 0, 1, 2, 3 (0, 20, 40, 55 deg); ISLs 0-1, 0-2, 1-2, 1-3, 2-3
+// dropped: 4 -> 7 in the satellites 4, 5, 6, 7 (180, 195, 210, 300 deg); ISLs 4-5, 4-6, 5-6 and the blocked 5-7, 6-7
+//          The walk 4 -> 5 -> 6 can only continue with the visible 6 -> 5, which leads back to a visited satellite.
+//
+// Expected scans: 0-1, 4-5 (t = 0), 1-3 (t = 444), 5-6 (t = 481)
+//===================================
+
+namespace {
+
+const float PI = 3.14159265f;
+const std::vector<std::pair<uint32_t, uint32_t>> EXPECTED_SCANS = {{0, 1}, {4, 5}, {1, 3}, {5, 6}};
+
+std::shared_ptr<const dmsc::PhysicalInstance> makeInstance() {
+    dmsc::Instance raw;
+    for (float degrees : {0.f, 20.f, 40.f, 55.f, 180.f, 195.f, 210.f, 300.f}) {
+        dmsc::StateVector sv;
+        sv.height_perigee = 1000.f;
+        sv.initial_true_anomaly = degrees * PI / 180.f;
+        raw.satellites.push_back(sv);
+    }
+    for (std::pair<uint32_t, uint32_t> isl : std::vector<std::pair<uint32_t, uint32_t>>{
+             {0, 1}, {0, 2}, {1, 2}, {1, 3}, {2, 3}, {4, 5}, {4, 6}, {5, 6}, {5, 7}, {6, 7}}) {
+        raw.edges.push_back(dmsc::Edge(isl.first, isl.second));
+    }
+    raw.edges.push_back(dmsc::Edge(0, 3, dmsc::EdgeType::SCHEDULED_COMMUNICATION));
+    raw.edges.push_back(dmsc::Edge(4, 7, dmsc::EdgeType::SCHEDULED_COMMUNICATION));
+    return std::make_shared<const dmsc::PhysicalInstance>(raw);
+}
+
+/**
+ * @brief True, if the message of the communication reaches its target when it is passed on along the scans.
+ */
+bool isServed(const dmsc::PhysicalInstance& instance, const dmsc::ScanCover& scans,
+              const dmsc::ScheduledCommunication& communication) {
+    std::vector<bool> has_message(instance.satelliteCount(), false);
+    has_message[communication.first] = true;
+    for (size_t i = 0; i < scans.size(); i++) {
+        const dmsc::InterSatelliteLink& isl = instance.getISLs()[scans.edgeIdx(i)];
+        if (has_message[isl.getV1Idx()] || has_message[isl.getV2Idx()]) {
+            has_message[isl.getV1Idx()] = true;
+            has_message[isl.getV2Idx()] = true;
+        }
+    }
+    return has_message[communication.second];
+}
+
+} // namespace
+
+int main() {
+    std::shared_ptr<const dmsc::PhysicalInstance> instance = makeInstance();
+    dmsc::SolverOptions options;
+    options.worker_count = 1;
+
+    // the paths with at most 3 edges are all paths, so k does not change the schedule
+    for (uint32_t k = 0; k <= 1; k++) {
+        dmsc::DmscSolution solution = dmsc::solver::GreedyNextKHop(instance, k, options).solve();
+        const dmsc::ScanCover& scans = solution.scan_cover;
+        bool expected = scans.size() == EXPECTED_SCANS.size();
+        for (size_t i = 0; expected && i < scans.size(); i++) {
+            const dmsc::InterSatelliteLink& isl = instance->getISLs()[scans.edgeIdx(i)];
+            expected = isl.getV1Idx() == EXPECTED_SCANS[i].first && isl.getV2Idx() == EXPECTED_SCANS[i].second;
+        }
+        bool served = isServed(*instance, scans, instance->scheduled_communications[0]);
+        bool dropped = !isServed(*instance, scans, instance->scheduled_communications[1]);
+        printf("k = %u: %zu scans, 0 -> 3 %s, 4 -> 7 %s\n", k, scans.size(), served ? "served" : "not served",
+               dropped ? "dropped" : "not dropped");
+        if (solution.cancelled || !expected || !served || !dropped) {
+            printf("k = %u: the scans 0-1, 4-5, 1-3, 5-6 expected, 0 -> 3 served and 4 -> 7 dropped\n", k);
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}